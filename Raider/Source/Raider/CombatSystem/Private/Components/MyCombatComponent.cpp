@@ -4,18 +4,36 @@
 #include "Components//MyCombatComponent.h"
 
 #include "DelayAction.h"
+#include "Animation/AnimMontage.h"
 #include "TimerManager.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Components/MyMontageDispatcherComponent.h"
 #include "Interfaces/MyCombatInterface.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "RaiderStats.h"
 #include "Structs/FSDamageInfo.h"
+#include "Subsystems/MyAttackTokenSubsystem.h"
+#include "Subsystems/MyCombatantGridSubsystem.h"
+#include "Subsystems/MyDamagePipelineSubsystem.h"
+#include "Subsystems/MyTeamRegistrySubsystem.h"
+#include "Subsystems/MyWeaponPoolSubsystem.h"
 #include "Weapon/WeaponBase.h"
 #include "WorldPartition/HLOD/DestructibleHLODComponent.h"
 
+DECLARE_CYCLE_STAT(TEXT("DamageAllNoneTeamMembers"), STAT_RaiderDamageAllNoneTeamMembers, STATGROUP_RaiderCombat);
+DECLARE_CYCLE_STAT(TEXT("ShouldProcessDamage"), STAT_RaiderShouldProcessDamage, STATGROUP_RaiderCombat);
+DECLARE_CYCLE_STAT(TEXT("Attack OnAttackMontageNotifyBegin"), STAT_RaiderAttackNotify, STATGROUP_RaiderCombat);
+
 
 // Sets default values for this component's properties
 UMyCombatComponent::UMyCombatComponent()
 	: IsWeaponEquipped(false),
+	  bShowHolsteredWeapon(false),
+	  LastHitGeneration(0),
+	  TeamId(0),
+	  bIsTeamRegistered(false),
 	  CurrentAttackTarget(nullptr),
 	  PlayerMontagePlayRate(1.3f),
       NPCMontagePlayRate(1.0f),
@@ -23,9 +41,34 @@ UMyCombatComponent::UMyCombatComponent()
 	  DefendRadius(250),
 	  bIsInvincible(false),
 	  bIsBlocking(false),
-	  bIsInterruptible(true)
+	  bIsInterruptible(true),
+	  MontageDispatcher(nullptr)
 {
 	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicatedByDefault(true);
+}
+
+void UMyCombatComponent::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	AddPreloadAsset(OutAssets, WeaponActorClass);
+	AddPreloadAsset(OutAssets, ShieldActorClass);
+	AddPreloadAsset(OutAssets, EquipMontage);
+	AddPreloadAsset(OutAssets, UnEquipMontage);
+	AddPreloadAsset(OutAssets, AttackMontage);
+	AddPreloadAsset(OutAssets, BlockMontage);
+	AddPreloadAsset(OutAssets, TakeHitMontage);
+}
+
+void UMyCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UMyCombatComponent, IsWeaponEquipped, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UMyCombatComponent, bIsInvincible, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UMyCombatComponent, bIsBlocking, Params);
 }
 
 
@@ -33,56 +76,190 @@ UMyCombatComponent::UMyCombatComponent()
 void UMyCombatComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// Montages are played through the owner's dispatcher, notifies are routed to the handlers once here
+	MontageDispatcher = UMyMontageDispatcherComponent::Get(GetOwner());
+	if (MontageDispatcher)
+	{
+		MontageDispatcher->AddMontageNotifyHandler(ResolveAsset(AttackMontage), FOnRoutedMontageNotify::CreateUObject(this, &UMyCombatComponent::OnAttackMontageNotifyBegin));
+		MontageDispatcher->AddNotifyHandler("BlockStart", FOnRoutedMontageNotify::CreateUObject(this, &UMyCombatComponent::OnBlockingMontageNotifyBegin));
+	}
+
+	TeamRegistry = GetWorld()->GetSubsystem<UMyTeamRegistrySubsystem>();
+	DamagePipeline = GetWorld()->GetSubsystem<UMyDamagePipelineSubsystem>();
+
+	AActor* Owner = GetOwner();
+	if (!Owner || !Owner->GetClass()->ImplementsInterface(UMyCombatInterface::StaticClass()))
+	{
+		return;
+	}
+
+	// Register the team once so team checks no longer go through the interface
+	const int32 TeamNumber = IMyCombatInterface::Execute_GetTeamNumber(Owner);
+	if (TeamRegistry)
+	{
+		TeamId = TeamRegistry->RegisterCombatant(Owner, TeamNumber);
+		bIsTeamRegistered = true;
+	}
+	else
+	{
+		TeamId = UMyTeamRegistrySubsystem::ToTeamId(TeamNumber);
+	}
+
+	// Track the owner in the combatant grid so melee attacks can find it without physics queries
+	if (UMyCombatantGridSubsystem* CombatantGrid = GetWorld()->GetSubsystem<UMyCombatantGridSubsystem>())
+	{
+		CombatantGrid->RegisterCombatant(this);
+	}
+}
+
+void UMyCombatComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (MontageDispatcher)
+	{
+		MontageDispatcher->RemoveNotifyHandlers(this);
+	}
+
+	if (UMyCombatantGridSubsystem* CombatantGrid = GetWorld()->GetSubsystem<UMyCombatantGridSubsystem>())
+	{
+		CombatantGrid->UnregisterCombatant(GetOwner());
+	}
+
+	if (TeamRegistry)
+	{
+		TeamRegistry->UnregisterCombatant(GetOwner());
+	}
+	bIsTeamRegistered = false;
+
+	// Tokens held or waited for by the owner go back to their targets
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->ReleaseAttacker(GetOwner());
+	}
+
+	// Weapons outlive their owner in the pool
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		ReleaseWeapon(WeaponActorObj);
+		ReleaseWeapon(ShieldActorObj);
+		SetWeaponEquipped(false);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UMyCombatComponent::EquipWeapon()
 {
-	if (EquipMontage && WeaponActorClass)
+	UAnimMontage* Montage = ResolveAsset(EquipMontage);
+	const TSubclassOf<AWeaponBase> WeaponClass = ResolveClass(WeaponActorClass);
+	if (Montage && WeaponClass)
 	{
-		WeaponActorObj = GetWorld()->SpawnActor<AWeaponBase>(WeaponActorClass, FVector::ZeroVector, FRotator::ZeroRotator);
+		// Draw the holstered weapon, otherwise take one from the pool
+		if (!WeaponActorObj || WeaponActorObj->GetClass() != WeaponClass)
+		{
+			ReleaseWeapon(WeaponActorObj);
+			WeaponActorObj = AcquireWeapon(WeaponClass);
+		}
 
-		if (const AActor* Owner = GetOwner())
+		if (WeaponActorObj && MontageDispatcher && MontageDispatcher->GetMesh())
 		{
-			if (USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-			{
-				AttachWeaponToSocket(WeaponActorObj, WeaponSocketName);
-				PlayEquipMontage(EquipMontage);
-				IsWeaponEquipped = true;
-			}
+			WeaponActorObj->SetActorHiddenInGame(false);
+			AttachWeaponToSocket(WeaponActorObj, WeaponSocketName);
+			PlayEquipMontage(Montage);
+			SetWeaponEquipped(true);
 		}
 	}
 }
 
 void UMyCombatComponent::UnEquipWeapon()
 {
-	if (UnEquipMontage && WeaponActorObj)
+	UAnimMontage* Montage = ResolveAsset(UnEquipMontage);
+	if (Montage && WeaponActorObj)
 	{
-		if (const AActor* Owner = GetOwner())
+		PlayUnEquipMontage(Montage);
+
+		// Holster the weapon when the character has a holster, otherwise return it to the pool
+		const USkeletalMeshComponent* MeshComponent = MontageDispatcher ? MontageDispatcher->GetMesh() : nullptr;
+		if (MeshComponent && !HolsterSocketName.IsNone() && MeshComponent->DoesSocketExist(HolsterSocketName))
 		{
-			PlayUnEquipMontage(UnEquipMontage);
-			GetWorld()->DestroyActor(WeaponActorObj);
-			IsWeaponEquipped = false;
+			AttachWeaponToSocket(WeaponActorObj, HolsterSocketName);
+			WeaponActorObj->SetActorHiddenInGame(!bShowHolsteredWeapon);
 		}
+		else
+		{
+			ReleaseWeapon(WeaponActorObj);
+		}
+		SetWeaponEquipped(false);
 	}
 }
 
 void UMyCombatComponent::EquipShield()
 {
-	if (ShieldActorClass)
+	if (const TSubclassOf<AWeaponBase> ShieldClass = ResolveClass(ShieldActorClass))
 	{
-		ShieldActorObj = GetWorld()->SpawnActor<AWeaponBase>(ShieldActorClass, FVector::ZeroVector, FRotator::ZeroRotator);
-		if (const AActor* Owner = GetOwner())
+		if (!ShieldActorObj || ShieldActorObj->GetClass() != ShieldClass)
 		{
-			AttachWeaponToSocket(ShieldActorObj, ShieldSocketName);
+			ReleaseWeapon(ShieldActorObj);
+			ShieldActorObj = AcquireWeapon(ShieldClass);
 		}
+		AttachWeaponToSocket(ShieldActorObj, ShieldSocketName);
+	}
+}
+
+void UMyCombatComponent::ResetCombatState()
+{
+	ReleaseWeapon(WeaponActorObj);
+	ReleaseWeapon(ShieldActorObj);
+	SetWeaponEquipped(false);
+
+	CurrentAttackTarget = nullptr;
+	SetBlocking(false);
+
+	// Tokens held or waited for by the owner go back to their targets
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->ReleaseAttacker(GetOwner());
 	}
 }
 
+AWeaponBase* UMyCombatComponent::AcquireWeapon(const TSubclassOf<AWeaponBase> WeaponClass) const
+{
+	if (UMyWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<UMyWeaponPoolSubsystem>())
+	{
+		return WeaponPool->AcquireWeapon(WeaponClass, GetOwner());
+	}
+
+	return GetWorld()->SpawnActor<AWeaponBase>(WeaponClass, FVector::ZeroVector, FRotator::ZeroRotator);
+}
+
+void UMyCombatComponent::ReleaseWeapon(TObjectPtr<AWeaponBase>& Weapon) const
+{
+	if (!Weapon)
+	{
+		return;
+	}
+
+	if (UMyWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<UMyWeaponPoolSubsystem>())
+	{
+		WeaponPool->ReleaseWeapon(Weapon);
+	}
+	else
+	{
+		GetWorld()->DestroyActor(Weapon);
+	}
+	Weapon = nullptr;
+}
+
 void UMyCombatComponent::AttachWeaponToSocket(AActor* WeaponActor, const FName SocketName) const
 {
 	if (const AActor* Owner = GetOwner())
 	{
-		USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>();
+		USkeletalMeshComponent* MeshComponent = MontageDispatcher ? MontageDispatcher->GetMesh() : nullptr;
+		if (!MeshComponent)
+		{
+			return;
+		}
+
 		if (MeshComponent->DoesSocketExist(SocketName))
 		{
 			if (WeaponActor)
@@ -103,106 +280,177 @@ void UMyCombatComponent::AttachWeaponToSocket(AActor* WeaponActor, const FName S
 
 void UMyCombatComponent::PlayEquipMontage(UAnimMontage* AnimMontage)
 {
-	if (!AnimMontage)
+	if (AnimMontage && MontageDispatcher)
 	{
-		return;
-	}
-
-	if (const AActor* Owner = GetOwner())
-	{
-		if (const USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
-			{
-				AnimInstance->Montage_Play(AnimMontage);
-
-				FOnMontageEnded MontageEndDelegate;
-				MontageEndDelegate.BindUObject(this, &UMyCombatComponent::OnEquipMontageEnded);
-				AnimInstance->Montage_SetEndDelegate(MontageEndDelegate, AnimMontage);
-			}
-		}
+		MontageDispatcher->PlayMontage(AnimMontage, 1.0f, this, &UMyCombatComponent::OnEquipMontageEnded);
 	}
 }
 
 void UMyCombatComponent::PlayUnEquipMontage(UAnimMontage* AnimMontage)
 {
-	if (!AnimMontage)
+	if (AnimMontage && MontageDispatcher)
 	{
-		return;
+		MontageDispatcher->PlayMontage(AnimMontage, 1.0f, this, &UMyCombatComponent::OnUnEquipMontageEnded);
 	}
+}
 
-	if (const AActor* Owner = GetOwner())
+TArray<AActor*> UMyCombatComponent::DamageAllNoneTeamMembers(const TArray<FHitResult>& HitResult, const FSDamageInfo& DamageInfo)
+{
+	FDamagedActorArray DamagedActors;
+	DamageAllNoneTeamMembers(MakeArrayView(HitResult), DamageInfo, DamagedActors);
+
+	return TArray<AActor*>(DamagedActors);
+}
+
+AActor* UMyCombatComponent::DamageFirstNoneTeamMembers(const TArray<FHitResult>& HitResult, const FSDamageInfo& DamageInfo)
+{
+	// Iterate through all hit actors
+	for (const FHitResult& Hit : HitResult)
 	{
-		if (const USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
-			{
-				AnimInstance->Montage_Play(AnimMontage);
+		AActor* HitActor = Hit.GetActor();
+		UMyCombatComponent* HitCombatComponent = HitActor ? HitActor->FindComponentByClass<UMyCombatComponent>() : nullptr;
 
-				FOnMontageEnded MontageEndDelegate;
-				MontageEndDelegate.BindUObject(this, &UMyCombatComponent::OnUnEquipMontageEnded);
-				AnimInstance->Montage_SetEndDelegate(MontageEndDelegate, AnimMontage);
-			}
+		// Damage only if the hit actor is hostile
+		if (HitActor && IsHostile(HitActor, HitCombatComponent))
+		{
+			ApplyDamage(HitActor, HitCombatComponent, DamageInfo);
+			return HitActor;
 		}
 	}
+	
+	return nullptr;
 }
 
-TArray<AActor*> UMyCombatComponent::DamageAllNoneTeamMembers(const TArray<FHitResult>& HitResult, const FSDamageInfo& DamageInfo)
+int32 UMyCombatComponent::DamageAllNoneTeamMembers(const TArrayView<const FHitResult> HitResult, const FSDamageInfo& DamageInfo,
+                                                   FDamagedActorArray& OutDamagedActors)
 {
-	// Clear DamagedActors
-	DamagedActors.Empty();
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderDamageAllNoneTeamMembers);
+
+	const int32 NumBefore = OutDamagedActors.Num();
+	const uint32 HitGeneration = NextHitGeneration();
 
-	// Iterate through all hit actors
 	for (const FHitResult& Hit : HitResult)
 	{
 		AActor* HitActor = Hit.GetActor();
-
-		// Skip if invalid or already take damaged
-		if (!HitActor || DamagedActors.Contains(HitActor))
+		if (HitActor)
 		{
-			continue;
+			TryDamageActor(HitActor, HitActor->FindComponentByClass<UMyCombatComponent>(), HitGeneration, DamageInfo, OutDamagedActors);
 		}
+	}
+
+	return OutDamagedActors.Num() - NumBefore;
+}
+
+int32 UMyCombatComponent::DamageAllNoneTeamMembers(const TArrayView<AActor* const> HitActors, const FSDamageInfo& DamageInfo,
+                                                   FDamagedActorArray& OutDamagedActors)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderDamageAllNoneTeamMembers);
 
-		// Damage only if the hit actor is on a different team
-		if (!IsOnSameTeam(GetOwner(), HitActor))
+	const int32 NumBefore = OutDamagedActors.Num();
+	const uint32 HitGeneration = NextHitGeneration();
+
+	for (AActor* HitActor : HitActors)
+	{
+		if (HitActor)
 		{
-			IMyCombatInterface::Execute_TakeDamage(HitActor, GetOwner(), DamageInfo);
-			DamagedActors.Add(HitActor);
+			TryDamageActor(HitActor, HitActor->FindComponentByClass<UMyCombatComponent>(), HitGeneration, DamageInfo, OutDamagedActors);
 		}
 	}
 
-	return DamagedActors;
+	return OutDamagedActors.Num() - NumBefore;
 }
 
-AActor* UMyCombatComponent::DamageFirstNoneTeamMembers(const TArray<FHitResult>& HitResult, const FSDamageInfo& DamageInfo)
+int32 UMyCombatComponent::DamageAllNoneTeamMembers(const TArrayView<UMyCombatComponent* const> HitCombatComponents, const FSDamageInfo& DamageInfo,
+                                                   FDamagedActorArray& OutDamagedActors)
 {
-	// Clear DamagedActors
-	DamagedActors.Empty();
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderDamageAllNoneTeamMembers);
 
-	// Iterate through all hit actors
-	for (const FHitResult& Hit : HitResult)
-	{
-		AActor* HitActor = Hit.GetActor();
+	const int32 NumBefore = OutDamagedActors.Num();
+	const uint32 HitGeneration = NextHitGeneration();
 
-		// Skip if invalid or already take damaged
-		if (!HitActor || DamagedActors.Contains(HitActor))
+	for (UMyCombatComponent* HitCombatComponent : HitCombatComponents)
+	{
+		if (AActor* HitActor = HitCombatComponent ? HitCombatComponent->GetOwner() : nullptr)
 		{
-			continue;
+			TryDamageActor(HitActor, HitCombatComponent, HitGeneration, DamageInfo, OutDamagedActors);
 		}
+	}
+
+	return OutDamagedActors.Num() - NumBefore;
+}
 
-		// Damage only if the hit actor is on a different team
-		if (!IsOnSameTeam(GetOwner(), HitActor))
+bool UMyCombatComponent::TryDamageActor(AActor* HitActor, UMyCombatComponent* HitCombatComponent, const uint32 HitGeneration,
+                                        const FSDamageInfo& DamageInfo, FDamagedActorArray& OutDamagedActors)
+{
+	// Skip if already damaged by this attack, combatants carry the stamp so no search is needed
+	if (HitCombatComponent)
+	{
+		if (HitCombatComponent->LastHitGeneration == HitGeneration)
 		{
-			IMyCombatInterface::Execute_TakeDamage(HitActor, GetOwner(), DamageInfo);
-			return HitActor;
+			return false;
 		}
+		HitCombatComponent->LastHitGeneration = HitGeneration;
 	}
-	
-	return nullptr;
+	else if (OutDamagedActors.Contains(HitActor))
+	{
+		return false;
+	}
+
+	// Damage only if the hit actor is hostile
+	if (!IsHostile(HitActor, HitCombatComponent))
+	{
+		return false;
+	}
+
+	ApplyDamage(HitActor, HitCombatComponent, DamageInfo);
+	OutDamagedActors.Add(HitActor);
+	return true;
+}
+
+void UMyCombatComponent::ApplyDamage(AActor* HitActor, UMyCombatComponent* HitCombatComponent, const FSDamageInfo& DamageInfo) const
+{
+	INC_DWORD_STAT(STAT_RaiderHitsApplied);
+
+	if (DamagePipeline)
+	{
+		DamagePipeline->QueueDamage(HitActor, HitCombatComponent, GetOwner(), DamageInfo);
+		return;
+	}
+
+	IMyCombatInterface::Execute_TakeDamage(HitActor, GetOwner(), DamageInfo);
+}
+
+uint32 UMyCombatComponent::NextHitGeneration()
+{
+	static uint32 HitGeneration = 0;
+
+	// Zero is the value of components that were never hit
+	if (++HitGeneration == 0)
+	{
+		++HitGeneration;
+	}
+	return HitGeneration;
+}
+
+bool UMyCombatComponent::IsHostile(AActor* OtherActor, const UMyCombatComponent* OtherCombatComponent) const
+{
+	// Both sides registered their team, this is a single matrix load
+	if (bIsTeamRegistered && OtherCombatComponent && OtherCombatComponent->bIsTeamRegistered)
+	{
+		return TeamRegistry->GetAttitude(TeamId, OtherCombatComponent->TeamId) == ETeamAttitude::Hostile;
+	}
+
+	return !IsOnSameTeam(GetOwner(), OtherActor);
 }
 
 bool UMyCombatComponent::IsOnSameTeam(AActor* OwnerActor, AActor* OtherActor) const
 {
+	ETeamAttitude::Type Attitude;
+	if (TeamRegistry && TeamRegistry->GetAttitude(OwnerActor, OtherActor, Attitude))
+	{
+		return Attitude == ETeamAttitude::Friendly;
+	}
+
 	if (!OwnerActor || !OwnerActor->GetClass()->ImplementsInterface(UMyCombatInterface::StaticClass()))
 	{
 		return false;
@@ -237,50 +485,36 @@ void UMyCombatComponent::GetCombatRange(float& OutAttackRadius, float& OutDefend
 
 void UMyCombatComponent::Attack(AActor* AttackTarget)
 {
-	if (!GetOwner() || !AttackMontage)
+	UAnimMontage* Montage = ResolveAsset(AttackMontage);
+	if (!GetOwner() || !Montage)
 	{
 		return;
 	}
 
-	PlayAttackMontage(AttackMontage);
+	PlayAttackMontage(Montage);
 	
 	CurrentAttackTarget = AttackTarget;
 }
 
 void UMyCombatComponent::PlayAttackMontage(UAnimMontage* AnimMontage)
 {
-	if (!AnimMontage)
+	if (!AnimMontage || !MontageDispatcher)
 	{
 		return;
 	}
 
-	if (AActor* Owner = GetOwner())
+	// Adjust play rate based on owner type
+	if (const ACharacter* CharacterOwner = Cast<ACharacter>(GetOwner()))
 	{
-		if (USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			UAnimInstance* AttackAnimInstance = MeshComponent->GetAnimInstance();
-
-			// Bind to montage notify
-			AttackAnimInstance->OnPlayMontageNotifyBegin.RemoveDynamic(this, &UMyCombatComponent::OnAttackMontageNotifyBegin);
-			AttackAnimInstance->OnPlayMontageNotifyBegin.AddDynamic(this, &UMyCombatComponent::OnAttackMontageNotifyBegin);
-
-			// Adjust play rate based on owner type
-			if (const ACharacter* CharacterOwner = Cast<ACharacter>(GetOwner()))
-			{
-				const float MontagePlayRate = CharacterOwner->IsPlayerControlled() ? PlayerMontagePlayRate : NPCMontagePlayRate;
-				AttackAnimInstance->Montage_Play(AnimMontage, MontagePlayRate);
-			}
-	
-			// Bind to montage end event
-			FOnMontageEnded MontageEndDelegate;
-			MontageEndDelegate.BindUObject(this, &UMyCombatComponent::OnAttackMontageEnded);
-			AttackAnimInstance->Montage_SetEndDelegate(MontageEndDelegate, AnimMontage);
-		}			
+		const float MontagePlayRate = CharacterOwner->IsPlayerControlled() ? PlayerMontagePlayRate : NPCMontagePlayRate;
+		MontageDispatcher->PlayMontage(AnimMontage, MontagePlayRate, this, &UMyCombatComponent::OnAttackMontageEnded);
 	}
 }
 
 void UMyCombatComponent::OnAttackMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
 {
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderAttackNotify);
+
 	OnAttackMontageNotify.Broadcast(NotifyName);
 }
 
@@ -297,6 +531,8 @@ void UMyCombatComponent::TriggerOnAttackEnd()
 
 bool UMyCombatComponent::ShouldProcessDamage(const FSDamageInfo& DamageInfo) const
 {
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderShouldProcessDamage);
+
 	// Determine the type of damage handling
 	if (bIsBlocking && DamageInfo.CanBeBlocked)
 	{
@@ -321,87 +557,127 @@ bool UMyCombatComponent::ShouldProcessDamage(const FSDamageInfo& DamageInfo) con
 
 void UMyCombatComponent::TakeHit()
 {
-	if (TakeHitMontage)
+	if (UAnimMontage* Montage = ResolveAsset(TakeHitMontage))
 	{
-		PlayTakeHitMontage(TakeHitMontage);
+		PlayTakeHitMontage(Montage);
 	}
 }
 
 void UMyCombatComponent::Block()
 {
-	if (BlockMontage)
+	if (UAnimMontage* Montage = ResolveAsset(BlockMontage))
 	{
-		PlayBlockingMontage(BlockMontage);
+		PlayBlockingMontage(Montage);
 	}
 }
 
 void UMyCombatComponent::PlayTakeHitMontage(UAnimMontage* AnimMontage)
 {
-	if (!AnimMontage)
+	if (AnimMontage && MontageDispatcher)
 	{
-		return;
+		INC_DWORD_STAT(STAT_RaiderReactionsPlayed);
+		MontageDispatcher->PlayMontage(AnimMontage, 1.0f, this, &UMyCombatComponent::OnTakeHitMontageEnded);
 	}
+}
 
-	if (const AActor* Owner = GetOwner())
+void UMyCombatComponent::PlayBlockingMontage(UAnimMontage* AnimMontage)
+{
+	if (AnimMontage && MontageDispatcher)
 	{
-		if (const USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
-			{
-				AnimInstance->Montage_Play(AnimMontage);
-
-				FOnMontageEnded MontageEndDelegate;
-				MontageEndDelegate.BindUObject(this, &UMyCombatComponent::OnTakeHitMontageEnded);
-				AnimInstance->Montage_SetEndDelegate(MontageEndDelegate, AnimMontage);
-			}
-		}
+		INC_DWORD_STAT(STAT_RaiderReactionsPlayed);
+		MontageDispatcher->PlayMontage(AnimMontage, 1.0f, this, &UMyCombatComponent::OnBlockingMontageEnded);
 	}
 }
 
-void UMyCombatComponent::PlayBlockingMontage(UAnimMontage* AnimMontage)
+void UMyCombatComponent::OnTakeHitMontageEnded(UAnimMontage* Montage, bool bInterrupted) const
 {
-	if (!AnimMontage)
+	OnTakeHitEnd.Broadcast();
+}
+
+void UMyCombatComponent::OnBlockingMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	SetBlocking(true);
+}
+
+void UMyCombatComponent::OnBlockingMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+{
+	SetBlocking(false);
+}
+
+void UMyCombatComponent::SetInvincible(const bool bInvincible)
+{
+	if (bIsInvincible != bInvincible)
 	{
-		return;
+		bIsInvincible = bInvincible;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UMyCombatComponent, bIsInvincible, this);
+		GetOwner()->FlushNetDormancy();
 	}
+}
 
-	if (const AActor* Owner = GetOwner())
+void UMyCombatComponent::SetWeaponEquipped(const bool bEquipped)
+{
+	if (IsWeaponEquipped != bEquipped)
 	{
-		if (const USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
-			{
-				// Bind to montage notify
-				AnimInstance->OnPlayMontageNotifyBegin.RemoveDynamic(this, &UMyCombatComponent::OnBlockingMontageNotifyBegin);
-				AnimInstance->OnPlayMontageNotifyBegin.AddDynamic(this, &UMyCombatComponent::OnBlockingMontageNotifyBegin);
-
-				// Play montage
-				AnimInstance->Montage_Play(AnimMontage);
-
-				// Montage end delegate
-				FOnMontageEnded MontageEndDelegate;
-				MontageEndDelegate.BindUObject(this, &UMyCombatComponent::OnBlockingMontageEnded);
-				AnimInstance->Montage_SetEndDelegate(MontageEndDelegate, AnimMontage);
-			}
-		}
+		IsWeaponEquipped = bEquipped;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UMyCombatComponent, IsWeaponEquipped, this);
+		GetOwner()->FlushNetDormancy();
 	}
 }
 
-void UMyCombatComponent::OnTakeHitMontageEnded(UAnimMontage* Montage, bool bInterrupted) const
+void UMyCombatComponent::SetBlocking(const bool bBlocking)
 {
-	OnTakeHitEnd.Broadcast();
+	if (bIsBlocking != bBlocking)
+	{
+		bIsBlocking = bBlocking;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UMyCombatComponent, bIsBlocking, this);
+		GetOwner()->FlushNetDormancy();
+	}
 }
 
-void UMyCombatComponent::OnBlockingMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
+void UMyCombatComponent::OnRep_IsWeaponEquipped()
 {
-	if (NotifyName == "BlockStart")
+	// Weapons don't replicate, a client takes its own visual weapon from the pool the first time one is drawn
+	if (!WeaponActorObj && IsWeaponEquipped)
 	{
-		bIsBlocking = true;
+		if (const TSubclassOf<AWeaponBase> WeaponClass = ResolveClass(WeaponActorClass))
+		{
+			WeaponActorObj = AcquireWeapon(WeaponClass);
+		}
+	}
+
+	if (!WeaponActorObj)
+	{
+		return;
+	}
+
+	const USkeletalMeshComponent* MeshComponent = MontageDispatcher ? MontageDispatcher->GetMesh() : nullptr;
+	if (IsWeaponEquipped)
+	{
+		WeaponActorObj->SetActorHiddenInGame(false);
+		AttachWeaponToSocket(WeaponActorObj, WeaponSocketName);
+	}
+	else if (MeshComponent && !HolsterSocketName.IsNone() && MeshComponent->DoesSocketExist(HolsterSocketName))
+	{
+		AttachWeaponToSocket(WeaponActorObj, HolsterSocketName);
+		WeaponActorObj->SetActorHiddenInGame(!bShowHolsteredWeapon);
+	}
+	else
+	{
+		WeaponActorObj->SetActorHiddenInGame(true);
 	}
 }
 
-void UMyCombatComponent::OnBlockingMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+void UMyCombatComponent::MulticastDamageApplied_Implementation(const FSDamageInfo& DamageInfo)
 {
-	bIsBlocking = false;
+	// The server reacted when it applied the damage
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return;
+	}
+
+	if (bIsInterruptible || DamageInfo.ShouldForceInterrupt)
+	{
+		OnDamageReact.Broadcast(DamageInfo.DamageReact);
+	}
 }
 
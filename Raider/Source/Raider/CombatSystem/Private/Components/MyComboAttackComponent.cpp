@@ -5,23 +5,78 @@
 
 #include "RaiderCharacter.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Components/MyCombatComponent.h"
+#include "Components/MyMontageDispatcherComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "RaiderStats.h"
+#include "Subsystems/MyCombatQuerySubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combo OnMontageNotifyBegin"), STAT_RaiderComboNotify, STATGROUP_RaiderCombat);
 
 
 // Sets default values for this component's properties
 UMyComboAttackComponent::UMyComboAttackComponent()
 	: OwnerCharacter(nullptr),
-	  AnimInstance(nullptr),
+	  MontageDispatcher(nullptr),
 	  CurrentAttackTarget(nullptr),
-	  CurrentComboIndex(0),
+	  ComboTable(nullptr),
+	  AttackHitTable(nullptr),
+	  InputBufferHead(0),
+	  HeldInput(EComboInput::None),
+	  CurrentNodeIndex(INDEX_NONE),
+	  CurrentNodeStartTime(0),
+	  ComboWindowOpenTime(0),
+	  ComboWindowLength(0),
+	  bIsComboWindowOpen(false),
+	  bIsComboWindowResolved(false),
+	  NumSupersededMontages(0),
 	  bIsAttacking(false),
-	  bIsNotifyBound(false),
-      bComboHeld(false),
 	  DefaultWalkSpeed(0),
 	  AttackWalkSpeed(50)
 {
 	PrimaryComponentTick.bCanEverTick = false;
+
+	for (int32& StartNode : StartNodes)
+	{
+		StartNode = INDEX_NONE;
+	}
+
+	// Default attack hits
+	FAttackHitData Slash;
+	Slash.NotifyName = "Slash";
+	Slash.Reach = 50.0f;
+	Slash.Radius = 150.0f;
+	Slash.DamageInfo.Amount = 10.0f;
+	DefaultAttackHits.Add(Slash);
+
+	FAttackHitData SlashB = Slash;
+	SlashB.NotifyName = "SlashB";
+	DefaultAttackHits.Add(SlashB);
+
+	FAttackHitData SlashC;
+	SlashC.NotifyName = "SlashC";
+	SlashC.Reach = 300.0f;
+	SlashC.Radius = 100.0f;
+	SlashC.DamageInfo.Amount = 20.0f;
+	DefaultAttackHits.Add(SlashC);
+}
+
+void UMyComboAttackComponent::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	// The combo table is a hard reference and loaded with the character, only its montages are streamed
+	if (ComboTable)
+	{
+		ComboTable->ForeachRow<FComboAttackData>(TEXT("GatherPreloadAssets"), [&OutAssets](const FName& RowName, const FComboAttackData& ComboAttack)
+		{
+			AddPreloadAsset(OutAssets, ComboAttack.AttackMontage);
+		});
+		return;
+	}
+
+	for (const TSoftObjectPtr<UAnimMontage>& Montage : ComboAttackMontages)
+	{
+		AddPreloadAsset(OutAssets, Montage);
+	}
 }
 
 
@@ -33,34 +88,228 @@ void UMyComboAttackComponent::BeginPlay()
 	OwnerCharacter = Cast<ACharacter>(GetOwner());
 	if (OwnerCharacter)
 	{
-		AnimInstance = OwnerCharacter->GetMesh()->GetAnimInstance();
-
 		DefaultWalkSpeed = OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed;
 	}
+
+	CompileAttackHits();
+	CompileComboGraph();
+
+	// Route each attack hit notify straight to its compiled hit
+	MontageDispatcher = UMyMontageDispatcherComponent::Get(GetOwner());
+	if (MontageDispatcher)
+	{
+		for (const TPair<FName, int32>& AttackHitNotify : AttackHitIndexByNotify)
+		{
+			MontageDispatcher->AddNotifyHandler(AttackHitNotify.Key,
+				FOnRoutedMontageNotify::CreateUObject(this, &UMyComboAttackComponent::OnMontageNotifyBegin, AttackHitNotify.Value));
+		}
+	}
+}
+
+void UMyComboAttackComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (MontageDispatcher)
+	{
+		MontageDispatcher->RemoveNotifyHandlers(this);
+	}
+
+	ClearComboWindow();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMyComboAttackComponent::CompileAttackHits()
+{
+	CompiledAttackHits.Reset();
+	AttackHitIndexByNotify.Reset();
+
+	auto AddAttackHit = [this](const FAttackHitData& AttackHit, const FName DefaultNotifyName)
+	{
+		const FName NotifyName = AttackHit.NotifyName.IsNone() ? DefaultNotifyName : AttackHit.NotifyName;
+		if (NotifyName.IsNone())
+		{
+			return;
+		}
+
+		const FCompiledAttackHit CompiledAttackHit = { AttackHit.Reach, AttackHit.Radius, AttackHit.DamageInfo };
+
+		// Later entries override earlier ones with the same notify
+		if (const int32* ExistingIndex = AttackHitIndexByNotify.Find(NotifyName))
+		{
+			CompiledAttackHits[*ExistingIndex] = CompiledAttackHit;
+		}
+		else
+		{
+			AttackHitIndexByNotify.Add(NotifyName, CompiledAttackHits.Add(CompiledAttackHit));
+		}
+	};
+
+	for (const FAttackHitData& AttackHit : DefaultAttackHits)
+	{
+		AddAttackHit(AttackHit, NAME_None);
+	}
+
+	if (AttackHitTable)
+	{
+		AttackHitTable->ForeachRow<FAttackHitData>(TEXT("CompileAttackHits"), [&AddAttackHit](const FName& RowName, const FAttackHitData& AttackHit)
+		{
+			AddAttackHit(AttackHit, RowName);
+		});
+	}
 }
 
-void UMyComboAttackComponent::HandleAttackInput(AActor* Target)
+void UMyComboAttackComponent::CompileComboGraph()
 {
-	if (!OwnerCharacter || !AnimInstance || !ComboAttackMontages.IsValidIndex(CurrentComboIndex))
+	ComboNodes.Reset();
+	ResolvedMontages.Reset();
+	for (int32& StartNode : StartNodes)
 	{
+		StartNode = INDEX_NONE;
+	}
+
+	if (!ComboTable)
+	{
+		// Linear light combo, continued when the previous attack ends
+		for (int32 Index = 0; Index < ComboAttackMontages.Num(); ++Index)
+		{
+			FCompiledComboNode& Node = ComboNodes.AddDefaulted_GetRef();
+			Node.AttackMontage = ResolveAsset(ComboAttackMontages[Index]);
+			ResolvedMontages.AddUnique(Node.AttackMontage);
+			Node.NextNodes[static_cast<uint8>(EComboInput::Light)] = (Index + 1) % ComboAttackMontages.Num();
+			Node.ComboWindowOpenTime = 1.0f;
+			Node.ComboWindowCloseTime = 1.0f;
+		}
+
+		if (ComboNodes.Num() > 0)
+		{
+			StartNodes[static_cast<uint8>(EComboInput::Light)] = 0;
+		}
 		return;
 	}
 
-	bComboHeld = true;
-	
-	if (!AnimInstance->IsAnyMontagePlaying())
+	TMap<FName, int32> NodeIndexByRow;
+	ComboTable->ForeachRow<FComboAttackData>(TEXT("CompileComboGraph"), [this, &NodeIndexByRow](const FName& RowName, const FComboAttackData& ComboAttack)
+	{
+		const int32 NodeIndex = ComboNodes.AddDefaulted();
+		NodeIndexByRow.Add(RowName, NodeIndex);
+
+		FCompiledComboNode& Node = ComboNodes[NodeIndex];
+		Node.AttackMontage = ResolveAsset(ComboAttack.AttackMontage);
+		ResolvedMontages.AddUnique(Node.AttackMontage);
+		Node.ComboWindowOpenTime = ComboAttack.ComboWindowOpenTime;
+		Node.ComboWindowCloseTime = FMath::Max(ComboAttack.ComboWindowCloseTime, ComboAttack.ComboWindowOpenTime);
+
+		// The first row with a start input starts the combo for that input
+		if (ComboAttack.StartInput != EComboInput::None && StartNodes[static_cast<uint8>(ComboAttack.StartInput)] == INDEX_NONE)
+		{
+			StartNodes[static_cast<uint8>(ComboAttack.StartInput)] = NodeIndex;
+		}
+	});
+
+	// Resolve the row names of the transitions now that every row has its node
+	ComboTable->ForeachRow<FComboAttackData>(TEXT("CompileComboGraph"), [this, &NodeIndexByRow](const FName& RowName, const FComboAttackData& ComboAttack)
+	{
+		FCompiledComboNode& Node = ComboNodes[NodeIndexByRow.FindChecked(RowName)];
+		for (const TPair<FName, FName>& NextCombo : ComboAttack.NextCombo)
+		{
+			const EComboInput Input = ParseComboInput(NextCombo.Key);
+			const int32* NextNodeIndex = NodeIndexByRow.Find(NextCombo.Value);
+			if (Input == EComboInput::None || !NextNodeIndex)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s: combo %s -> %s from %s is ignored"),
+				       *ComboTable->GetName(), *NextCombo.Key.ToString(), *NextCombo.Value.ToString(), *RowName.ToString());
+				continue;
+			}
+
+			Node.NextNodes[static_cast<uint8>(Input)] = *NextNodeIndex;
+		}
+	});
+
+	// Tables without start inputs start with the first row
+	if (ComboNodes.Num() > 0 && StartNodes[static_cast<uint8>(EComboInput::Light)] == INDEX_NONE &&
+		StartNodes[static_cast<uint8>(EComboInput::Heavy)] == INDEX_NONE)
+	{
+		StartNodes[static_cast<uint8>(EComboInput::Light)] = 0;
+	}
+}
+
+EComboInput UMyComboAttackComponent::ParseComboInput(const FName InputName)
+{
+	if (InputName == "X" || InputName == "Light")
+	{
+		return EComboInput::Light;
+	}
+
+	if (InputName == "Y" || InputName == "Heavy")
+	{
+		return EComboInput::Heavy;
+	}
+
+	return EComboInput::None;
+}
+
+bool UMyComboAttackComponent::HandleAttackInput(AActor* Target, const EComboInput Input)
+{
+	if (!OwnerCharacter || !MontageDispatcher || Input == EComboInput::None || Input == EComboInput::Count)
 	{
+		return false;
+	}
+
+	const uint8 InputIndex = static_cast<uint8>(Input);
+
+	// Start a new combo
+	if (!bIsAttacking)
+	{
+		if (MontageDispatcher->IsAnyMontagePlaying() || !ComboNodes.IsValidIndex(StartNodes[InputIndex]))
+		{
+			return false;
+		}
+
 		bIsAttacking = true;
+		HeldInput = Input;
 		CurrentAttackTarget = Target;
-		PlayComboMontage(CurrentComboIndex);
+		PlayComboNode(StartNodes[InputIndex]);
+		return true;
+	}
+
+	// Inputs after the combo window or without a transition don't continue the combo
+	const int32 NextNodeIndex = ComboNodes[CurrentNodeIndex].NextNodes[InputIndex];
+	if (NextNodeIndex == INDEX_NONE || (bIsComboWindowResolved && !bIsComboWindowOpen))
+	{
+		return false;
+	}
+
+	HeldInput = Input;
+
+	if (bIsComboWindowOpen)
+	{
+		PlayComboNode(NextNodeIndex);
+		return true;
+	}
+
+	// Resolved when the combo window opens
+	FComboInputEvent& InputEvent = InputBuffer[InputBufferHead];
+	InputEvent.Input = Input;
+	InputEvent.Timestamp = FPlatformTime::Seconds();
+	InputBufferHead = (InputBufferHead + 1) % InputBuffer.Num();
+	return true;
+}
+
+void UMyComboAttackComponent::ReleaseAttackInput(const EComboInput Input)
+{
+	if (HeldInput == Input)
+	{
+		HeldInput = EComboInput::None;
 	}
 }
 
 void UMyComboAttackComponent::ResetCombo()
 {
-	CurrentComboIndex = 0;
+	ClearComboWindow();
+
+	CurrentNodeIndex = INDEX_NONE;
 	bIsAttacking = false;
-	bComboHeld = false;
+	bIsComboWindowResolved = false;
 	CurrentAttackTarget = nullptr;
 
 	if (OwnerCharacter && OwnerCharacter->GetCharacterMovement())
@@ -69,16 +318,12 @@ void UMyComboAttackComponent::ResetCombo()
 	}
 }
 
-void UMyComboAttackComponent::PlayComboMontage(int32 ComboIndex)
+void UMyComboAttackComponent::PlayComboNode(const int32 NodeIndex)
 {
-	if (!AnimInstance || !ComboAttackMontages.IsValidIndex(ComboIndex))
-	{
-		return;
-	}
-
-	UAnimMontage* MontageToPlay = ComboAttackMontages[ComboIndex];
-	if (!MontageToPlay)
+	const FCompiledComboNode& Node = ComboNodes[NodeIndex];
+	if (!MontageDispatcher || !Node.AttackMontage)
 	{
+		ResetCombo();
 		return;
 	}
 
@@ -88,151 +333,147 @@ void UMyComboAttackComponent::PlayComboMontage(int32 ComboIndex)
 		OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed = AttackWalkSpeed;
 	}
 
-	// Bind notify only once
-	if (!bIsNotifyBound)
+	// The replaced attack still reports its interrupted end
+	if (CurrentNodeIndex != INDEX_NONE && MontageDispatcher->IsAnyMontagePlaying())
 	{
-		AnimInstance->OnPlayMontageNotifyBegin.AddDynamic(this, &UMyComboAttackComponent::OnMontageNotifyBegin);
-		bIsNotifyBound = true;
+		++NumSupersededMontages;
 	}
 
+	ClearComboWindow();
+	CurrentNodeIndex = NodeIndex;
+	bIsComboWindowResolved = false;
+
 	const float Rate = OwnerCharacter->IsPlayerControlled() ? PlayerMontagePlayRate : NPCMontagePlayRate;
-	AnimInstance->Montage_Play(MontageToPlay, Rate);
+	MontageDispatcher->PlayMontage(Node.AttackMontage, Rate, this, &UMyComboAttackComponent::OnMontageEnded);
 
-	// Bind end delegate
-	FOnMontageEnded EndDelegate;
-	EndDelegate.BindUObject(this, &UMyComboAttackComponent::OnMontageEnded);
-	AnimInstance->Montage_SetEndDelegate(EndDelegate, MontageToPlay);
+	// Schedule the combo window, inputs are matched against it by timestamp
+	const float Duration = Node.AttackMontage->GetPlayLength() / FMath::Max(Rate * Node.AttackMontage->RateScale, UE_KINDA_SMALL_NUMBER);
+	const float WindowOpenDelay = Node.ComboWindowOpenTime * Duration;
+
+	// Inputs are stamped with the platform clock, which keeps running within a frame and ignores time dilation
+	const float TimeDilation = FMath::Max(GetWorld()->GetWorldSettings()->GetEffectiveTimeDilation(), UE_KINDA_SMALL_NUMBER);
+	CurrentNodeStartTime = FPlatformTime::Seconds();
+	ComboWindowOpenTime = CurrentNodeStartTime + WindowOpenDelay / TimeDilation;
+	ComboWindowLength = (Node.ComboWindowCloseTime - Node.ComboWindowOpenTime) * Duration;
+
+	GetWorld()->GetTimerManager().SetTimer(ComboWindowOpenTimer, this, &UMyComboAttackComponent::OnComboWindowOpen,
+	                                       FMath::Max(WindowOpenDelay, UE_KINDA_SMALL_NUMBER), false);
 }
 
-void UMyComboAttackComponent::OnMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& Payload)
+void UMyComboAttackComponent::OnComboWindowOpen()
 {
-	ARaiderCharacter* RaiderCharacter = Cast<ARaiderCharacter>(OwnerCharacter);
-	if (!RaiderCharacter || !RaiderCharacter->CombatComponent)
+	if (TryContinueCombo() || ComboWindowLength <= 0.0f)
 	{
 		return;
 	}
-	
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(OwnerCharacter);
-
-	TArray<FHitResult> HitResults;
-	TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes;
-	ObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECC_Pawn));
-
-	// Slash
-	if (NotifyName == "Slash")
-	{
-		const FVector Start = RaiderCharacter->GetActorLocation();
-		const FVector End = Start + RaiderCharacter->GetActorForwardVector() * 50.0f;
-		const float Radius = 150.0f;
-		const float Damage = 10.0f;
-		
-		const bool bHit = UKismetSystemLibrary::SphereTraceMultiForObjects(
-			GetWorld(),
-			Start,
-			End,
-			Radius,
-			ObjectTypes,
-			false,
-			ActorsToIgnore,
-			EDrawDebugTrace::None,
-			HitResults,
-			true
-		);
-		
-		// Apply damage to all valid actors in the hit results
-		if (bHit && HitResults.Num() > 0)
-		{
-			FSDamageInfo DamageInfo;
-			DamageInfo.Amount = Damage;
-			DamageInfo.DamageType = EDamageType::Melee;
-			DamageInfo.DamageReact = EDamageReact::Hit;
-			RaiderCharacter->CombatComponent->DamageAllNoneTeamMembers(HitResults, DamageInfo);
-		}
+
+	bIsComboWindowOpen = true;
+	GetWorld()->GetTimerManager().SetTimer(ComboWindowCloseTimer, this, &UMyComboAttackComponent::OnComboWindowClose, ComboWindowLength, false);
+}
+
+void UMyComboAttackComponent::OnComboWindowClose()
+{
+	bIsComboWindowOpen = false;
+}
+
+bool UMyComboAttackComponent::TryContinueCombo()
+{
+	bIsComboWindowResolved = true;
+
+	const int32 NextNodeIndex = ResolveBufferedInput();
+	if (NextNodeIndex == INDEX_NONE)
+	{
+		return false;
 	}
 
-	// SlashB
-	if (NotifyName == "SlashB")
-	{
-		const FVector Start = RaiderCharacter->GetActorLocation();
-		const FVector End = Start + RaiderCharacter->GetActorForwardVector() * 50.0f;
-		const float Radius = 150.0f;
-		const float Damage = 10.0f;
-		
-		const bool bHit = UKismetSystemLibrary::SphereTraceMultiForObjects(
-			GetWorld(),
-			Start,
-			End,
-			Radius,
-			ObjectTypes,
-			false,
-			ActorsToIgnore,
-			EDrawDebugTrace::None,
-			HitResults,
-			true
-		);
-		
-		// Apply damage to all valid actors in the hit results
-		if (bHit && HitResults.Num() > 0)
+	PlayComboNode(NextNodeIndex);
+	return true;
+}
+
+int32 UMyComboAttackComponent::ResolveBufferedInput() const
+{
+	if (!ComboNodes.IsValidIndex(CurrentNodeIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	const FCompiledComboNode& Node = ComboNodes[CurrentNodeIndex];
+	const double EarliestTimestamp = FMath::Max(CurrentNodeStartTime, ComboWindowOpenTime - InputBufferTime);
+
+	// Newest input first, older entries belong to earlier attacks once one is too old
+	for (int32 Offset = 1; Offset <= InputBuffer.Num(); ++Offset)
+	{
+		const FComboInputEvent& InputEvent = InputBuffer[(InputBufferHead - Offset + InputBuffer.Num()) % InputBuffer.Num()];
+		if (InputEvent.Timestamp < EarliestTimestamp)
 		{
-			FSDamageInfo DamageInfo;
-			DamageInfo.Amount = Damage;
-			DamageInfo.DamageType = EDamageType::Melee;
-			DamageInfo.DamageReact = EDamageReact::Hit;
-			RaiderCharacter->CombatComponent->DamageAllNoneTeamMembers(HitResults, DamageInfo);
+			break;
 		}
-	}
 
-	// SlashC
-	if (NotifyName == "SlashC")
-	{
-		const FVector Start = RaiderCharacter->GetActorLocation();
-		const FVector End = Start + RaiderCharacter->GetActorForwardVector() * 300.0f;
-		const float Radius = 100.0f;
-		const float Damage = 20.0f;
-		
-		const bool bHit = UKismetSystemLibrary::SphereTraceMultiForObjects(
-			GetWorld(),
-			Start,
-			End,
-			Radius,
-			ObjectTypes,
-			false,
-			ActorsToIgnore,
-			EDrawDebugTrace::None,
-			HitResults,
-			true
-		);
-		
-		// Apply damage to all valid actors in the hit results
-		if (bHit && HitResults.Num() > 0)
+		const int32 NextNodeIndex = Node.NextNodes[static_cast<uint8>(InputEvent.Input)];
+		if (NextNodeIndex != INDEX_NONE)
 		{
-			FSDamageInfo DamageInfo;
-			DamageInfo.Amount = Damage;
-			DamageInfo.DamageType = EDamageType::Melee;
-			DamageInfo.DamageReact = EDamageReact::Hit;
-			RaiderCharacter->CombatComponent->DamageAllNoneTeamMembers(HitResults, DamageInfo);
+			return NextNodeIndex;
 		}
 	}
+
+	// Holding the input keeps the combo going
+	return HeldInput != EComboInput::None ? Node.NextNodes[static_cast<uint8>(HeldInput)] : INDEX_NONE;
 }
 
-void UMyComboAttackComponent::OnMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+void UMyComboAttackComponent::ClearComboWindow()
 {
-	if (bInterrupted)
+	if (const UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(ComboWindowOpenTimer);
+		World->GetTimerManager().ClearTimer(ComboWindowCloseTimer);
+	}
+
+	bIsComboWindowOpen = false;
+}
+
+void UMyComboAttackComponent::OnMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& Payload, const int32 AttackHitIndex)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderComboNotify);
+
+	ARaiderCharacter* RaiderCharacter = Cast<ARaiderCharacter>(OwnerCharacter);
+	if (!RaiderCharacter || !RaiderCharacter->CombatComponent)
+	{
+		return;
+	}
+
+	UMyCombatQuerySubsystem* CombatQuerySubsystem = GetWorld()->GetSubsystem<UMyCombatQuerySubsystem>();
+	if (!CombatQuerySubsystem)
 	{
-		ResetCombo();
 		return;
 	}
-	
-	if (bComboHeld)
+
+	const FCompiledAttackHit& AttackHit = CompiledAttackHits[AttackHitIndex];
+	const FVector Start = RaiderCharacter->GetActorLocation();
+	const FVector End = Start + RaiderCharacter->GetActorForwardVector() * AttackHit.Reach;
+
+	CombatQuerySubsystem->QueueHitQuery(RaiderCharacter->CombatComponent, Start, End, AttackHit.Radius, AttackHit.DamageInfo);
+}
+
+void UMyComboAttackComponent::OnMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+{
+	// Attacks replaced by the next combo attack end interrupted
+	if (bInterrupted && NumSupersededMontages > 0)
 	{
-		CurrentComboIndex = (CurrentComboIndex + 1) % ComboAttackMontages.Num();
-		PlayComboMontage(CurrentComboIndex);
+		--NumSupersededMontages;
+		return;
 	}
-	else
+
+	if (bInterrupted)
 	{
 		ResetCombo();
+		return;
 	}
-}
 
+	// Combo windows at the very end of the attack are resolved here
+	if (!bIsComboWindowResolved && TryContinueCombo())
+	{
+		return;
+	}
 
+	ResetCombo();
+}
@@ -3,20 +3,63 @@
 
 #include "Components/MyHealthComponent.h"
 
+#include "Animation/AnimMontage.h"
+#include "Components/MyMontageDispatcherComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "RaiderStats.h"
+#include "Subsystems/MyAttackTokenSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("RequestAttackToken"), STAT_RaiderRequestAttackToken, STATGROUP_RaiderAI);
+
 // Sets default values for this component's properties
 UMyHealthComponent::UMyHealthComponent()
 	: Health(100),
       MaxHealth(100),
-      AttackTokenCount(1)
+      AttackTokenCount(1),
+	  MontageDispatcher(nullptr)
 {
 	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicatedByDefault(true);
+}
+
+void UMyHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UMyHealthComponent, Health, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UMyHealthComponent, MaxHealth, Params);
+}
+
+void UMyHealthComponent::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	AddPreloadAsset(OutAssets, DeathMontage);
 }
 
 // Called when the game starts
 void UMyHealthComponent::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	MontageDispatcher = UMyMontageDispatcherComponent::Get(GetOwner());
+
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->RegisterTarget(GetOwner(), AttackTokenCount);
+	}
+}
+
+void UMyHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->UnregisterTarget(GetOwner());
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UMyHealthComponent::TakeHealing(const float HealAmount)
@@ -26,8 +69,7 @@ void UMyHealthComponent::TakeHealing(const float HealAmount)
 		return;
 	}
 	
-	Health += HealAmount;
-	Health = FMath::Clamp(Health, 0.0f, MaxHealth);
+	SetHealth(FMath::Clamp(Health + HealAmount, 0.0f, MaxHealth));
 }
 
 void UMyHealthComponent::TakeDamage(const float Amount)
@@ -38,8 +80,7 @@ void UMyHealthComponent::TakeDamage(const float Amount)
 	}
 
 	// Take damage
-	Health -= Amount;
-	Health = FMath::Clamp(Health, 0.0f, MaxHealth);
+	SetHealth(FMath::Clamp(Health - Amount, 0.0f, MaxHealth));
 
 	// Handle death if health reaches zero
 	if (!IsAlive())
@@ -53,61 +94,101 @@ bool UMyHealthComponent::IsAlive() const
 	return Health > 0;
 }
 
+void UMyHealthComponent::ResetHealth()
+{
+	SetHealth(MaxHealth);
+
+	// Leases and waiters from the previous life are dropped with the old pool
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->UnregisterTarget(GetOwner());
+		AttackTokens->RegisterTarget(GetOwner(), AttackTokenCount);
+	}
+}
+
 bool UMyHealthComponent::RequestAttackToken(AActor* RequestingAttacker, const int32 Amount)
 {
 	if (!RequestingAttacker)
 		return false;
 
-	// If Requesting attacker has token already, return true to prevent token loss
-	if (Attackers.Contains(RequestingAttacker))
-		return true;
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderRequestAttackToken);
 
-	// Prevent exceeding available tokens
-	if (AttackTokenCount < Amount)
-		return false;
-	
-	// Assign token
-	AttackTokenCount -= Amount;
-	Attackers.Add(RequestingAttacker);
-	//UE_LOG(LogTemp, Warning, TEXT("%s give token to %s"), *GetOwner()->GetName(), *RequestingAttacker->GetName());
-	
-	return true;
+	UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>();
+	return !AttackTokens || AttackTokens->RequestToken(GetOwner(), RequestingAttacker, Amount);
 }
 
 void UMyHealthComponent::ReturnAttackToken(AActor* RequestingAttacker, const int32 Amount)
 {
-	if (Attackers.Contains(RequestingAttacker))
+	// Leases return all tokens of the attacker at once
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
 	{
-		AttackTokenCount += Amount;
-		Attackers.Remove(RequestingAttacker);
-		//UE_LOG(LogTemp, Warning, TEXT("%s received token from %s"), *GetOwner()->GetName(), *RequestingAttacker->GetName());
+		AttackTokens->ReturnToken(GetOwner(), RequestingAttacker);
 	}
 }
 
-void UMyHealthComponent::PlayDeathMontage(UAnimMontage* AnimMontage) const
+void UMyHealthComponent::SetHealth(const float NewHealth)
+{
+	if (Health != NewHealth)
+	{
+		Health = NewHealth;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UMyHealthComponent, Health, this);
+
+		// A net dormant owner, such as a passive NPC hit from behind, wouldn't send the change otherwise
+		GetOwner()->FlushNetDormancy();
+	}
+}
+
+void UMyHealthComponent::SetMaxHealth(const float NewMaxHealth)
+{
+	if (MaxHealth != NewMaxHealth)
+	{
+		MaxHealth = NewMaxHealth;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UMyHealthComponent, MaxHealth, this);
+		GetOwner()->FlushNetDormancy();
+	}
+
+	SetHealth(FMath::Min(Health, MaxHealth));
+}
+
+void UMyHealthComponent::OnRep_Health(const float OldHealth)
 {
-	if (const AActor* Owner = GetOwner())
+	const bool bWasAlive = OldHealth > 0;
+	if (bWasAlive && !IsAlive())
 	{
-		if (USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
+		if (UAnimMontage* Montage = ResolveAsset(DeathMontage))
 		{
-			if (UAnimInstance* AnimInstance = MeshComponent->GetAnimInstance())
-			{
-				AnimInstance->Montage_Play(AnimMontage);
-			}
+			PlayDeathMontage(Montage);
 		}
 	}
+	else if (!bWasAlive && IsAlive() && MontageDispatcher)
+	{
+		// Recycled by the server, the new life starts without the death pose
+		MontageDispatcher->StopMontages(0.0f);
+	}
+}
+
+void UMyHealthComponent::PlayDeathMontage(UAnimMontage* AnimMontage) const
+{
+	// Death montages are only for show, nothing listens to their notifies
+	if (MontageDispatcher && !IsRunningDedicatedServer())
+	{
+		MontageDispatcher->PlayMontage(AnimMontage);
+	}
 }
 
 void UMyHealthComponent::PlayDeathRagDoll() const
 {
-	if (const AActor* Owner = GetOwner())
+	// Nobody sees the body fall on a dedicated server
+	if (IsRunningDedicatedServer())
 	{
-		if (USkeletalMeshComponent* MeshComponent = Owner->FindComponentByClass<USkeletalMeshComponent>())
-		{
-			MeshComponent->SetSimulatePhysics(true);
-			MeshComponent->WakeAllRigidBodies();
-			MeshComponent->SetCollisionProfileName("Ragdoll");
-		}
+		return;
+	}
+
+	if (USkeletalMeshComponent* MeshComponent = MontageDispatcher ? MontageDispatcher->GetMesh() : nullptr)
+	{
+		MeshComponent->SetSimulatePhysics(true);
+		MeshComponent->WakeAllRigidBodies();
+		MeshComponent->SetCollisionProfileName("Ragdoll");
 	}
 }
 
@@ -0,0 +1,359 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Components/MyMontageDispatcherComponent.h"
+
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "RaiderStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Dispatch OnMontageNotifyBegin"), STAT_RaiderDispatchNotify, STATGROUP_RaiderCombat);
+
+FMontageNotifyDispatchStats UMyMontageDispatcherComponent::DispatchStats;
+
+static FAutoConsoleCommand CmdDumpNotifyStats(
+	TEXT("Raider.Combat.DumpNotifyStats"),
+	TEXT("Prints the montage notify dispatch counters. Pass 'reset' to clear them afterwards."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FMontageNotifyDispatchStats& Stats = UMyMontageDispatcherComponent::GetDispatchStats();
+		const double DispatchMs = FPlatformTime::ToMilliseconds64(Stats.DispatchCycles);
+
+		UE_LOG(LogTemp, Display, TEXT("Montage notifies: %llu received, %llu handler calls, %llu unrouted, %.3f ms total, %.4f ms per notify"),
+		       Stats.NumReceived, Stats.NumDispatched, Stats.NumUnrouted, DispatchMs,
+		       Stats.NumReceived > 0 ? DispatchMs / Stats.NumReceived : 0.0);
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			UMyMontageDispatcherComponent::ResetDispatchStats();
+		}
+	}));
+
+
+UMyMontageDispatcherComponent::UMyMontageDispatcherComponent()
+	: Mesh(nullptr),
+	  AnimInstance(nullptr)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// Cache before any component BeginPlay can play a montage
+	bWantsInitializeComponent = true;
+}
+
+void UMyMontageDispatcherComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	const AActor* Owner = GetOwner();
+	if (const ACharacter* OwnerCharacter = Cast<ACharacter>(Owner))
+	{
+		SetMesh(OwnerCharacter->GetMesh());
+	}
+	else if (Owner)
+	{
+		SetMesh(Owner->FindComponentByClass<USkeletalMeshComponent>());
+	}
+}
+
+void UMyMontageDispatcherComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetMesh(nullptr);
+	RemoveNotifyHandlers(nullptr);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UMyMontageDispatcherComponent* UMyMontageDispatcherComponent::Get(const AActor* Actor)
+{
+	return Actor ? Actor->FindComponentByClass<UMyMontageDispatcherComponent>() : nullptr;
+}
+
+void UMyMontageDispatcherComponent::SetMesh(USkeletalMeshComponent* InMesh)
+{
+	if (Mesh == InMesh)
+	{
+		return;
+	}
+
+	UnbindAnimInstance();
+	if (Mesh)
+	{
+		Mesh->OnAnimInitialized.RemoveDynamic(this, &UMyMontageDispatcherComponent::OnMeshAnimInitialized);
+	}
+
+	Mesh = InMesh;
+
+	if (Mesh)
+	{
+		Mesh->OnAnimInitialized.AddDynamic(this, &UMyMontageDispatcherComponent::OnMeshAnimInitialized);
+
+		// Nobody sees the pose on a dedicated server, montages still tick for their notifies and root motion
+		if (IsRunningDedicatedServer())
+		{
+			Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesAndRefreshBonesWhenPlayingMontages;
+		}
+	}
+	BindAnimInstance();
+}
+
+float UMyMontageDispatcherComponent::PlayMontage(UAnimMontage* Montage, const float PlayRate) const
+{
+	if (!Montage || !AnimInstance)
+	{
+		return 0.0f;
+	}
+
+	return AnimInstance->Montage_Play(Montage, PlayRate);
+}
+
+void UMyMontageDispatcherComponent::AddMontageEndHandler(UAnimMontage* Montage, FOnMontageEnded&& Handler)
+{
+	const FAnimMontageInstance* MontageInstance = AnimInstance ? AnimInstance->GetActiveInstanceForMontage(Montage) : nullptr;
+	if (MontageInstance && Handler.IsBound())
+	{
+		FPendingMontageEnd& PendingEnd = PendingMontageEnds.Add(MontageInstance->GetInstanceID());
+		PendingEnd.Montage = Montage;
+		PendingEnd.Handler = MoveTemp(Handler);
+	}
+}
+
+void UMyMontageDispatcherComponent::AddNotifyHandler(const FName NotifyName, FOnRoutedMontageNotify&& Handler)
+{
+	if (NotifyName.IsNone() || !Handler.IsBound())
+	{
+		return;
+	}
+
+	// A handler subscribing from a notify must not grow the route that is being iterated
+	if (NotifyDispatchDepth > 0)
+	{
+		DeferredNameHandlers.Emplace(NotifyName, MoveTemp(Handler));
+		return;
+	}
+
+	NotifyHandlersByName.FindOrAdd(NotifyName).Add(MoveTemp(Handler));
+}
+
+void UMyMontageDispatcherComponent::AddMontageNotifyHandler(const UAnimMontage* Montage, FOnRoutedMontageNotify&& Handler)
+{
+	if (!Montage || !Handler.IsBound())
+	{
+		return;
+	}
+
+	if (NotifyDispatchDepth > 0)
+	{
+		DeferredMontageHandlers.Emplace(Montage, MoveTemp(Handler));
+		return;
+	}
+
+	NotifyHandlersByMontage.FindOrAdd(Montage).Add(MoveTemp(Handler));
+}
+
+void UMyMontageDispatcherComponent::RemoveNotifyHandlers(const UObject* HandlerObject)
+{
+	// A null object removes every handler
+	auto UnbindRoutes = [HandlerObject](auto& Routes)
+	{
+		for (auto& Route : Routes)
+		{
+			for (FOnRoutedMontageNotify& Handler : Route.Value)
+			{
+				if (!HandlerObject || Handler.IsBoundToObject(HandlerObject))
+				{
+					Handler.Unbind();
+				}
+			}
+		}
+	};
+
+	UnbindRoutes(NotifyHandlersByName);
+	UnbindRoutes(NotifyHandlersByMontage);
+
+	// Deferred handlers are pairs of route key and handler as well
+	for (TPair<FName, FOnRoutedMontageNotify>& Deferred : DeferredNameHandlers)
+	{
+		if (!HandlerObject || Deferred.Value.IsBoundToObject(HandlerObject))
+		{
+			Deferred.Value.Unbind();
+		}
+	}
+
+	for (TPair<TObjectKey<UAnimSequenceBase>, FOnRoutedMontageNotify>& Deferred : DeferredMontageHandlers)
+	{
+		if (!HandlerObject || Deferred.Value.IsBoundToObject(HandlerObject))
+		{
+			Deferred.Value.Unbind();
+		}
+	}
+
+	// Handler lists are being iterated when a handler ends play of its owner
+	if (NotifyDispatchDepth > 0)
+	{
+		bHasUnboundNotifyHandlers = true;
+	}
+	else
+	{
+		CompactNotifyHandlers();
+	}
+}
+
+void UMyMontageDispatcherComponent::CompactNotifyHandlers()
+{
+	auto CompactRoutes = [](auto& Routes)
+	{
+		for (auto It = Routes.CreateIterator(); It; ++It)
+		{
+			It.Value().RemoveAllSwap([](const FOnRoutedMontageNotify& Handler)
+			{
+				return !Handler.IsBound();
+			});
+
+			if (It.Value().Num() == 0)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	};
+
+	CompactRoutes(NotifyHandlersByName);
+	CompactRoutes(NotifyHandlersByMontage);
+}
+
+void UMyMontageDispatcherComponent::FinishNotifyDispatch()
+{
+	if (bHasUnboundNotifyHandlers)
+	{
+		bHasUnboundNotifyHandlers = false;
+		CompactNotifyHandlers();
+	}
+
+	// Handlers removed again before the dispatch finished were unbound and are skipped
+	for (TPair<FName, FOnRoutedMontageNotify>& Deferred : DeferredNameHandlers)
+	{
+		AddNotifyHandler(Deferred.Key, MoveTemp(Deferred.Value));
+	}
+	DeferredNameHandlers.Reset();
+
+	for (TPair<TObjectKey<UAnimSequenceBase>, FOnRoutedMontageNotify>& Deferred : DeferredMontageHandlers)
+	{
+		if (Deferred.Value.IsBound())
+		{
+			NotifyHandlersByMontage.FindOrAdd(Deferred.Key).Add(MoveTemp(Deferred.Value));
+		}
+	}
+	DeferredMontageHandlers.Reset();
+}
+
+void UMyMontageDispatcherComponent::StopMontages(const float BlendOutTime) const
+{
+	if (AnimInstance)
+	{
+		AnimInstance->Montage_Stop(BlendOutTime);
+	}
+}
+
+bool UMyMontageDispatcherComponent::IsAnyMontagePlaying() const
+{
+	return AnimInstance && AnimInstance->IsAnyMontagePlaying();
+}
+
+void UMyMontageDispatcherComponent::BindAnimInstance()
+{
+	AnimInstance = Mesh ? Mesh->GetAnimInstance() : nullptr;
+	if (!AnimInstance)
+	{
+		return;
+	}
+
+	AnimInstance->OnMontageEnded.AddDynamic(this, &UMyMontageDispatcherComponent::OnMontageEnded);
+	AnimInstance->OnPlayMontageNotifyBegin.AddDynamic(this, &UMyMontageDispatcherComponent::OnMontageNotifyBegin);
+}
+
+void UMyMontageDispatcherComponent::UnbindAnimInstance()
+{
+	if (AnimInstance)
+	{
+		AnimInstance->OnMontageEnded.RemoveDynamic(this, &UMyMontageDispatcherComponent::OnMontageEnded);
+		AnimInstance->OnPlayMontageNotifyBegin.RemoveDynamic(this, &UMyMontageDispatcherComponent::OnMontageNotifyBegin);
+	}
+
+	// The plays of the old anim instance don't report their end anymore
+	PendingMontageEnds.Reset();
+	AnimInstance = nullptr;
+}
+
+void UMyMontageDispatcherComponent::OnMeshAnimInitialized()
+{
+	// The mesh replaced its anim instance, move the bindings over
+	if (Mesh && Mesh->GetAnimInstance() != AnimInstance)
+	{
+		UnbindAnimInstance();
+		BindAnimInstance();
+	}
+}
+
+void UMyMontageDispatcherComponent::OnMontageEnded(UAnimMontage* Montage, const bool bInterrupted)
+{
+	if (!AnimInstance)
+	{
+		return;
+	}
+
+	// Plays of the same montage end in the order they were started, take the oldest ended instance
+	int32 EndedInstanceID = INDEX_NONE;
+	for (const TPair<int32, FPendingMontageEnd>& PendingEnd : PendingMontageEnds)
+	{
+		if (PendingEnd.Value.Montage == Montage && !AnimInstance->GetInstanceForID(PendingEnd.Key) &&
+			(EndedInstanceID == INDEX_NONE || PendingEnd.Key < EndedInstanceID))
+		{
+			EndedInstanceID = PendingEnd.Key;
+		}
+	}
+
+	// The handler may play the next montage, which adds to the map
+	FPendingMontageEnd EndedPlay;
+	if (EndedInstanceID != INDEX_NONE && PendingMontageEnds.RemoveAndCopyValue(EndedInstanceID, EndedPlay))
+	{
+		EndedPlay.Handler.ExecuteIfBound(Montage, bInterrupted);
+	}
+}
+
+void UMyMontageDispatcherComponent::OnMontageNotifyBegin(const FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderDispatchNotify);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	int32 NumDispatched = 0;
+	++NotifyDispatchDepth;
+
+	auto Dispatch = [&](const FNotifyHandlerList* Handlers)
+	{
+		if (Handlers)
+		{
+			for (const FOnRoutedMontageNotify& Handler : *Handlers)
+			{
+				Handler.ExecuteIfBound(NotifyName, BranchingPointPayload);
+				++NumDispatched;
+			}
+		}
+	};
+
+	Dispatch(NotifyHandlersByName.Find(NotifyName));
+	if (BranchingPointPayload.SequenceAsset && NotifyHandlersByMontage.Num() > 0)
+	{
+		Dispatch(NotifyHandlersByMontage.Find(BranchingPointPayload.SequenceAsset));
+	}
+
+	--NotifyDispatchDepth;
+	if (NotifyDispatchDepth == 0)
+	{
+		FinishNotifyDispatch();
+	}
+
+	++DispatchStats.NumReceived;
+	DispatchStats.NumDispatched += NumDispatched;
+	DispatchStats.NumUnrouted += NumDispatched == 0 ? 1 : 0;
+	DispatchStats.DispatchCycles += FPlatformTime::Cycles64() - StartCycles;
+}
@@ -4,22 +4,45 @@
 #include "Components/MySpinAttackComponent.h"
 
 #include "RaiderCharacter.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Components/MyCombatComponent.h"
+#include "Components/MyMontageDispatcherComponent.h"
+#include "RaiderStats.h"
 #include "Structs/FSDamageInfo.h"
+#include "Subsystems/MyAssetPreloadSubsystem.h"
+#include "Subsystems/MyCombatQuerySubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spin OnAttackMontageNotifyBegin"), STAT_RaiderSpinNotify, STATGROUP_RaiderCombat);
 
 
 // Sets default values for this component's properties
 UMySpinAttackComponent::UMySpinAttackComponent()
-	: SpinMontage(nullptr),
+	: SpinLoopSectionName("Loop"),
+	  DefaultSpinLoopStartTime(1.54f),
+	  SpinRadius(150.0f),
+	  SpinDamage(20.0f),
+	  bContinuousDamage(false),
+	  ReHitInterval(0.5f),
 	  OwnerCharacter(nullptr),
+	  MontageDispatcher(nullptr),
 	  bIsSpinning(false),
+	  SpinElapsedTime(0),
+	  SpinLoopStartTime(0),
+	  LastSpinLocation(FVector::ZeroVector),
       DefaultWalkSpeed(0),
       AttackWalkSpeed(50)
 {
-	PrimaryComponentTick.bCanEverTick = false;
+	// Ticks only while spinning
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UMySpinAttackComponent::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	AddPreloadAsset(OutAssets, SpinMontage);
 }
 
 
@@ -30,6 +53,61 @@ void UMySpinAttackComponent::BeginPlay()
 
 	OwnerCharacter = Cast<ARaiderCharacter>(GetOwner());
 	DefaultWalkSpeed = OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed;
+
+	// The montage streams in with the owner's assets, the loop start is read from it once loaded, right away when it already is
+	SpinLoopStartTime = DefaultSpinLoopStartTime;
+	if (UMyAssetPreloadSubsystem* AssetPreload = GetWorld()->GetSubsystem<UMyAssetPreloadSubsystem>())
+	{
+		const TSoftClassPtr<AActor> OwnerClass(GetOwner()->GetClass());
+		AssetPreload->PreloadClasses(MakeArrayView(&OwnerClass, 1), FOnAssetPreloadComplete::CreateUObject(this, &UMySpinAttackComponent::OnSpinMontagePreloaded));
+	}
+
+	MontageDispatcher = UMyMontageDispatcherComponent::Get(OwnerCharacter);
+	if (MontageDispatcher)
+	{
+		MontageDispatcher->AddNotifyHandler("Spin", FOnRoutedMontageNotify::CreateUObject(this, &UMySpinAttackComponent::OnAttackMontageNotifyBegin));
+	}
+}
+
+void UMySpinAttackComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (MontageDispatcher)
+	{
+		MontageDispatcher->RemoveNotifyHandlers(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMySpinAttackComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!bIsSpinning)
+	{
+		return;
+	}
+
+	const float PreviousElapsedTime = SpinElapsedTime;
+	SpinElapsedTime += DeltaTime;
+
+	// Only the part of the frame after the loop start rotates
+	const float SpinTime = SpinElapsedTime - FMath::Max(PreviousElapsedTime, SpinLoopStartTime);
+	if (SpinTime > 0.0f)
+	{
+		UpdateSpin(SpinTime);
+	}
+
+	if (bContinuousDamage)
+	{
+		UpdateSpinDamage();
+	}
+
+	// Stop spinning after max duration
+	if (SpinElapsedTime >= MaxSpinDuration)
+	{
+		StopSpinAttack();
+	}
 }
 
 void UMySpinAttackComponent::StartSpinAttack()
@@ -43,24 +121,16 @@ void UMySpinAttackComponent::StartSpinAttack()
 	OriginalMeshRotation = OwnerCharacter->GetMesh()->GetRelativeRotation();
 	OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed = AttackWalkSpeed;
 
-	// Play startup montage
-	if (SpinMontage)
+	// Play startup montage, the spin advances every frame once it plays
+	UAnimMontage* Montage = ResolveAsset(SpinMontage);
+	if (Montage && MontageDispatcher)
 	{
-		UAnimInstance* AnimInstance = OwnerCharacter->GetMesh()->GetAnimInstance();
-		if (AnimInstance)
+		if (MontageDispatcher->PlayMontage(Montage) > 0.0f)
 		{
-			AnimInstance->OnPlayMontageNotifyBegin.RemoveDynamic(this, &UMySpinAttackComponent::OnAttackMontageNotifyBegin);
-			AnimInstance->OnPlayMontageNotifyBegin.AddDynamic(this, &UMySpinAttackComponent::OnAttackMontageNotifyBegin);
-			
-			AnimInstance->Montage_Play(SpinMontage);
-
-			// Delay before entering loop
-			GetWorld()->GetTimerManager().SetTimer(
-				SpinTransitionTimer, this, &UMySpinAttackComponent::EnterSpinLoop, 1.54, false);
-
-			// Stop spinning after max duration
-			GetWorld()->GetTimerManager().SetTimer(
-				SpinDurationTimer, this, &UMySpinAttackComponent::StopSpinAttack, MaxSpinDuration, false);
+			SpinElapsedTime = 0.0f;
+			LastSpinLocation = OwnerCharacter->GetActorLocation();
+			NextHitTimes.Reset();
+			SetComponentTickEnabled(true);
 		}
 	}
 }
@@ -73,11 +143,7 @@ void UMySpinAttackComponent::StopSpinAttack()
 	}
 
 	bIsSpinning = false;
-
-	// Stop rotation and transition timers
-	GetWorld()->GetTimerManager().ClearTimer(SpinLoopTimer);
-	GetWorld()->GetTimerManager().ClearTimer(SpinTransitionTimer);
-	GetWorld()->GetTimerManager().ClearTimer(SpinDurationTimer);
+	SetComponentTickEnabled(false);
 
 	// Reset mesh rotation
 	OwnerCharacter->GetMesh()->SetRelativeRotation(OriginalMeshRotation);
@@ -86,71 +152,112 @@ void UMySpinAttackComponent::StopSpinAttack()
 	OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed = DefaultWalkSpeed;
 
 	// Stop spin animation
-	if (UAnimInstance* AnimInstance = OwnerCharacter->GetMesh()->GetAnimInstance())
+	if (MontageDispatcher)
 	{
-		AnimInstance->Montage_Stop(0.1f);
+		MontageDispatcher->StopMontages(0.1f);
 	}
 }
 
-void UMySpinAttackComponent::EnterSpinLoop()
+void UMySpinAttackComponent::OnSpinMontagePreloaded(double LoadSeconds)
 {
-	// Call UpdateSpin every 0.01 seconds
-	GetWorld()->GetTimerManager().SetTimer(
-		SpinLoopTimer, this, &UMySpinAttackComponent::UpdateSpin, 0.01f, true);
+	if (const UAnimMontage* Montage = SpinMontage.Get())
+	{
+		SpinLoopStartTime = ResolveSpinLoopStartTime(*Montage);
+	}
 }
 
-void UMySpinAttackComponent::UpdateSpin()
+float UMySpinAttackComponent::ResolveSpinLoopStartTime(const UAnimMontage& Montage) const
 {
-	if (!OwnerCharacter || !bIsSpinning)
+	const int32 SectionIndex = Montage.GetSectionIndex(SpinLoopSectionName);
+	if (SectionIndex == INDEX_NONE)
 	{
-		return;
+		return DefaultSpinLoopStartTime;
+	}
+
+	float SectionStartTime;
+	float SectionEndTime;
+	Montage.GetSectionStartAndEndTime(SectionIndex, SectionStartTime, SectionEndTime);
+
+	// Section times are in montage time, the montage plays at its rate scale
+	return SectionStartTime / FMath::Max(Montage.RateScale, UE_KINDA_SMALL_NUMBER);
+}
+
+void UMySpinAttackComponent::UpdateSpin(const float SpinTime)
+{
+	float SpeedScale = 1.0f;
+	if (!SpinSpeedCurveName.IsNone() && MontageDispatcher && MontageDispatcher->GetAnimInstance())
+	{
+		MontageDispatcher->GetAnimInstance()->GetCurveValue(SpinSpeedCurveName, SpeedScale);
 	}
 
 	FRotator NewRotation = OwnerCharacter->GetMesh()->GetRelativeRotation();
-	NewRotation.Yaw += SpinRotationSpeed * 0.01f;
+	NewRotation.Yaw = FRotator::NormalizeAxis(NewRotation.Yaw + SpinRotationSpeed * SpeedScale * SpinTime);
 	OwnerCharacter->GetMesh()->SetRelativeRotation(NewRotation);
 }
 
-void UMySpinAttackComponent::OnAttackMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
+void UMySpinAttackComponent::UpdateSpinDamage()
 {
-	if (NotifyName != "Spin" || !OwnerCharacter || !OwnerCharacter->CombatComponent)
+	UMyCombatComponent* CombatComponent = OwnerCharacter->CombatComponent;
+	UMyCombatQuerySubsystem* CombatQuerySubsystem = GetWorld()->GetSubsystem<UMyCombatQuerySubsystem>();
+	if (!CombatComponent || !CombatQuerySubsystem)
 	{
 		return;
 	}
-	
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(OwnerCharacter);
-	
-	TArray<FHitResult> HitResults;
-	TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes;
-	ObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECC_Pawn));
-	
-	// Perform a multi-hit sphere trace around the player
-	const FVector Center = OwnerCharacter->GetActorLocation();
-	const float Radius = 150.f;
-	
-	const bool bHit = UKismetSystemLibrary::SphereTraceMultiForObjects(
-		GetWorld(),
-		Center,
-		Center,
-		Radius,
-		ObjectTypes,
-		false,
-		ActorsToIgnore,
-		EDrawDebugTrace::None,
-		HitResults,
-		true
-	);
-	
-	// Apply damage to all valid actors in the hit results
-	if (bHit && HitResults.Num() > 0)
-	{
-		FSDamageInfo DamageInfo;
-		DamageInfo.Amount = 20;
-		DamageInfo.DamageType = EDamageType::Melee;
-		DamageInfo.DamageReact = EDamageReact::Hit;
-
-		OwnerCharacter->CombatComponent->DamageAllNoneTeamMembers(HitResults, DamageInfo);
+
+	// One query per frame, swept along the movement since the last frame
+	const FVector SpinLocation = OwnerCharacter->GetActorLocation();
+	ScratchHitActors.Reset();
+	CombatQuerySubsystem->QueryHitActors(CombatComponent, LastSpinLocation, SpinLocation, SpinRadius, ScratchHitActors);
+	LastSpinLocation = SpinLocation;
+
+	// Skip the targets still on their re-hit cooldown
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	ScratchHitActors.RemoveAllSwap([this, CurrentTime](const AActor* HitActor)
+	{
+		const double* NextHitTime = NextHitTimes.Find(HitActor);
+		return NextHitTime && *NextHitTime > CurrentTime;
+	});
+
+	if (ScratchHitActors.Num() == 0)
+	{
+		return;
+	}
+
+	FDamagedActorArray DamagedActors;
+	CombatComponent->DamageAllNoneTeamMembers(MakeArrayView(ScratchHitActors), MakeSpinDamageInfo(), DamagedActors);
+
+	for (AActor* DamagedActor : DamagedActors)
+	{
+		NextHitTimes.Add(DamagedActor, CurrentTime + ReHitInterval);
 	}
 }
 
+FSDamageInfo UMySpinAttackComponent::MakeSpinDamageInfo() const
+{
+	FSDamageInfo DamageInfo;
+	DamageInfo.Amount = SpinDamage;
+	DamageInfo.DamageType = EDamageType::Melee;
+	DamageInfo.DamageReact = EDamageReact::Hit;
+	return DamageInfo;
+}
+
+void UMySpinAttackComponent::OnAttackMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderSpinNotify);
+
+	// Continuous spins deal their damage every frame instead
+	if (bContinuousDamage || !OwnerCharacter || !OwnerCharacter->CombatComponent)
+	{
+		return;
+	}
+
+	UMyCombatQuerySubsystem* CombatQuerySubsystem = GetWorld()->GetSubsystem<UMyCombatQuerySubsystem>();
+	if (!CombatQuerySubsystem)
+	{
+		return;
+	}
+
+	// Hit everything around the player
+	const FVector Center = OwnerCharacter->GetActorLocation();
+	CombatQuerySubsystem->QueueHitQuery(OwnerCharacter->CombatComponent, Center, Center, SpinRadius, MakeSpinDamageInfo());
+}
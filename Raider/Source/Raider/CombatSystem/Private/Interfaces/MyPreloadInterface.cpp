@@ -0,0 +1,4 @@
+// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Interfaces/MyPreloadInterface.h"
@@ -0,0 +1,15 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Settings/MyTeamSettings.h"
+
+UMyTeamSettings::UMyTeamSettings()
+	: DefaultAttitude(ETeamAttitude::Hostile),
+	  SameTeamAttitude(ETeamAttitude::Friendly)
+{
+}
+
+FName UMyTeamSettings::GetCategoryName() const
+{
+	return TEXT("Game");
+}
@@ -0,0 +1 @@
+﻿#include "Structs/FAttackHitData.h"
@@ -1,5 +1,19 @@
 ﻿#include "Structs/FSDamageInfo.h"
 
+namespace DamageInfoNetSerialization
+{
+	/** Number of values of each enum, update when one of them gains a value */
+	constexpr uint8 NumDamageTypes = static_cast<uint8>(EDamageType::Environment) + 1;
+	constexpr uint8 NumDamageReacts = static_cast<uint8>(EDamageReact::Death) + 1;
+
+	/** The type and the reaction are combined as Type + React * NumDamageTypes into the low 5 bits, the flags take the high 3 */
+	constexpr uint8 FirstFlagBit = 5;
+	static_assert(NumDamageTypes * NumDamageReacts <= (1 << FirstFlagBit), "Damage type and reaction no longer fit into one byte with the flags");
+
+	/** Steps per damage point of the quantized amount */
+	constexpr float AmountScale = 10.0f;
+}
+
 FSDamageInfo::FSDamageInfo()
 	: Amount(0.0f),
 	  DamageType(EDamageType::None),
@@ -31,6 +45,40 @@ FSDamageInfo::FSDamageInfo(float InAmount, EDamageType InDamageType, EDamageReac
 {
 }
 
+bool FSDamageInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace DamageInfoNetSerialization;
+
+	// Damage is never negative, healing has its own path
+	uint32 QuantizedAmount = Ar.IsSaving() ? FMath::RoundToInt(FMath::Max(Amount, 0.0f) * AmountScale) : 0;
+	Ar.SerializeIntPacked(QuantizedAmount);
+
+	uint8 Packed = 0;
+	if (Ar.IsSaving())
+	{
+		const uint8 TypeAndReact = static_cast<uint8>(static_cast<uint8>(DamageType) + static_cast<uint8>(DamageReact) * NumDamageTypes);
+		Packed = static_cast<uint8>(TypeAndReact |
+			(ShouldDamageInvisible ? 1 << FirstFlagBit : 0) |
+			(ShouldForceInterrupt ? 1 << (FirstFlagBit + 1) : 0) |
+			(CanBeBlocked ? 1 << (FirstFlagBit + 2) : 0));
+	}
+	Ar << Packed;
+
+	if (Ar.IsLoading())
+	{
+		const uint8 TypeAndReact = static_cast<uint8>(Packed & ((1 << FirstFlagBit) - 1));
+		Amount = QuantizedAmount / AmountScale;
+		DamageType = static_cast<EDamageType>(TypeAndReact % NumDamageTypes);
+		DamageReact = static_cast<EDamageReact>(FMath::Min<uint8>(TypeAndReact / NumDamageTypes, NumDamageReacts - 1));
+		ShouldDamageInvisible = (Packed & (1 << FirstFlagBit)) != 0;
+		ShouldForceInterrupt = (Packed & (1 << (FirstFlagBit + 1))) != 0;
+		CanBeBlocked = (Packed & (1 << (FirstFlagBit + 2))) != 0;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
 FString FSDamageInfo::ToString() const
 {
 	return FString::Printf(TEXT("Damage: %.2f, Type: %d, React: %d, Invisible: %s, Interrupt: %s, Blocked: %s"),
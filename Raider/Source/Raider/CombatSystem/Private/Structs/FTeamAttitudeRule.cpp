@@ -0,0 +1 @@
+﻿#include "Structs/FTeamAttitudeRule.h"
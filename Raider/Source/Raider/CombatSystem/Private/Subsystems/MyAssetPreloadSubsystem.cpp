@@ -0,0 +1,174 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyAssetPreloadSubsystem.h"
+
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Interfaces/MyPreloadInterface.h"
+#include "UObject/UObjectHash.h"
+
+void UMyAssetPreloadSubsystem::Deinitialize()
+{
+	// Canceled handles don't call their delegates, pending preloads never complete
+	for (const TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		Handle->CancelHandle();
+	}
+
+	Handles.Empty();
+	Preloads.Empty();
+	RequestedAssets.Empty();
+	ReferencedAssets.Empty();
+
+	Super::Deinitialize();
+}
+
+int32 UMyAssetPreloadSubsystem::PreloadClasses(const TConstArrayView<TSoftClassPtr<AActor>> Classes, FOnAssetPreloadComplete OnComplete)
+{
+	const int32 PreloadId = NextPreloadId++;
+	FAssetPreload& Preload = Preloads.Add(PreloadId);
+	Preload.OnComplete = MoveTemp(OnComplete);
+	Preload.StartTime = FPlatformTime::Seconds();
+
+	TArray<FSoftObjectPath> Assets;
+	for (const TSoftClassPtr<AActor>& Class : Classes)
+	{
+		if (Class.IsNull())
+		{
+			continue;
+		}
+
+		bool bIsAlreadyInSet = false;
+		Preload.Assets.Add(Class.ToSoftObjectPath(), &bIsAlreadyInSet);
+		if (!bIsAlreadyInSet)
+		{
+			Assets.Add(Class.ToSoftObjectPath());
+			++Preload.NumClasses;
+		}
+	}
+
+	RequestPass(PreloadId, MoveTemp(Assets));
+	return PreloadId;
+}
+
+void UMyAssetPreloadSubsystem::RequestPass(const int32 PreloadId, TArray<FSoftObjectPath>&& Assets)
+{
+	FAssetPreload* Preload = Preloads.Find(PreloadId);
+	if (!Preload)
+	{
+		return;
+	}
+
+	if (Assets.Num() == 0)
+	{
+		FinishPreload(PreloadId);
+		return;
+	}
+
+	++Preload->NumPasses;
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		bool bIsAlreadyInSet = false;
+		RequestedAssets.Add(Asset, &bIsAlreadyInSet);
+		Preload->NumNewAssets += bIsAlreadyInSet ? 0 : 1;
+	}
+
+	// Assets requested by another preload are requested again, the pass then waits for them to finish loading.
+	// The delegate runs right away when everything is loaded already, which may finish the preload.
+	const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &UMyAssetPreloadSubsystem::OnPassLoaded, PreloadId, Assets);
+	const TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(MoveTemp(Assets), OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+	if (Handle.IsValid())
+	{
+		Handles.Add(Handle);
+	}
+}
+
+void UMyAssetPreloadSubsystem::OnPassLoaded(const int32 PreloadId, TArray<FSoftObjectPath> Assets)
+{
+	FAssetPreload* Preload = Preloads.Find(PreloadId);
+	if (!Preload)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> NextAssets;
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		const TArray<FSoftObjectPath>* Referenced = ReferencedAssets.Find(Asset);
+		if (!Referenced)
+		{
+			TArray<FSoftObjectPath> Gathered;
+			if (UClass* Class = Cast<UClass>(Asset.ResolveObject()))
+			{
+				GatherClassAssets(Class, Gathered);
+			}
+			Referenced = &ReferencedAssets.Add(Asset, MoveTemp(Gathered));
+		}
+
+		for (const FSoftObjectPath& ReferencedAsset : *Referenced)
+		{
+			bool bIsAlreadyInSet = false;
+			Preload->Assets.Add(ReferencedAsset, &bIsAlreadyInSet);
+			if (!bIsAlreadyInSet)
+			{
+				NextAssets.Add(ReferencedAsset);
+			}
+		}
+	}
+
+	RequestPass(PreloadId, MoveTemp(NextAssets));
+}
+
+void UMyAssetPreloadSubsystem::GatherClassAssets(UClass* Class, TArray<FSoftObjectPath>& OutAssets) const
+{
+	const UObject* DefaultObject = Class->GetDefaultObject();
+	if (const IMyPreloadInterface* Preloadable = Cast<IMyPreloadInterface>(DefaultObject))
+	{
+		Preloadable->GatherPreloadAssets(OutAssets);
+	}
+
+	// Components created in a constructor are subobjects of the defaults
+	ForEachObjectWithOuter(DefaultObject, [&OutAssets](const UObject* Subobject)
+	{
+		if (const IMyPreloadInterface* Preloadable = Cast<IMyPreloadInterface>(Subobject))
+		{
+			Preloadable->GatherPreloadAssets(OutAssets);
+		}
+	}, false);
+
+	// Components added in a Blueprint are templates of its construction script, overridden per child Blueprint
+	UBlueprintGeneratedClass* ActualClass = Cast<UBlueprintGeneratedClass>(Class);
+	for (const UClass* SuperClass = Class; SuperClass; SuperClass = SuperClass->GetSuperClass())
+	{
+		const UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(SuperClass);
+		if (!BlueprintClass || !BlueprintClass->SimpleConstructionScript)
+		{
+			continue;
+		}
+
+		for (const USCS_Node* Node : BlueprintClass->SimpleConstructionScript->GetAllNodes())
+		{
+			if (const IMyPreloadInterface* Preloadable = Cast<IMyPreloadInterface>(Node ? Node->GetActualComponentTemplate(ActualClass) : nullptr))
+			{
+				Preloadable->GatherPreloadAssets(OutAssets);
+			}
+		}
+	}
+}
+
+void UMyAssetPreloadSubsystem::FinishPreload(const int32 PreloadId)
+{
+	FAssetPreload Preload;
+	if (!Preloads.RemoveAndCopyValue(PreloadId, Preload))
+	{
+		return;
+	}
+
+	const double LoadSeconds = FPlatformTime::Seconds() - Preload.StartTime;
+	UE_LOG(LogTemp, Log, TEXT("Preload %d finished: %d classes, %d assets (%d new), %d passes, %.1f ms"),
+	       PreloadId, Preload.NumClasses, Preload.Assets.Num(), Preload.NumNewAssets, Preload.NumPasses, LoadSeconds * 1000.0);
+
+	Preload.OnComplete.ExecuteIfBound(LoadSeconds);
+}
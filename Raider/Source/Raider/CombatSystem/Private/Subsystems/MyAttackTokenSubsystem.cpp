@@ -0,0 +1,302 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyAttackTokenSubsystem.h"
+
+#include "Algo/BinarySearch.h"
+#include "Engine/World.h"
+#include "RaiderStats.h"
+
+static TAutoConsoleVariable<float> CVarAttackTokenLeaseTime(
+	TEXT("Raider.Combat.AttackTokenLeaseTime"),
+	5.0f,
+	TEXT("Seconds an attacker holds an attack token before it returns on its own. Requesting it again renews the lease."));
+
+DECLARE_CYCLE_STAT(TEXT("RequestToken"), STAT_RaiderRequestToken, STATGROUP_RaiderAI);
+DECLARE_CYCLE_STAT(TEXT("RequestTokenOrWait"), STAT_RaiderRequestTokenOrWait, STATGROUP_RaiderAI);
+
+void UMyAttackTokenSubsystem::Deinitialize()
+{
+	// Waiting tasks are torn down with the world, they don't need a notification
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UMyAttackTokenSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMyAttackTokenSubsystem, STATGROUP_Tickables);
+}
+
+void UMyAttackTokenSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	if (CurrentTime < NextExpireTime)
+	{
+		return;
+	}
+
+	NextExpireTime = TNumericLimits<double>::Max();
+
+	FResolvedCallbacks Granted;
+	for (TPair<TObjectKey<AActor>, FAttackTokenPool>& TargetPool : Pools)
+	{
+		FAttackTokenPool& Pool = TargetPool.Value;
+		bool bReleasedTokens = false;
+
+		// Expired leases and destroyed attackers give their tokens back
+		for (int32 LeaseIndex = Pool.Leases.Num() - 1; LeaseIndex >= 0; --LeaseIndex)
+		{
+			const FAttackTokenLease& Lease = Pool.Leases[LeaseIndex];
+			if (Lease.ExpireTime <= CurrentTime || !Lease.Attacker.IsValid())
+			{
+				Pool.Available += Lease.Amount;
+				Pool.Leases.RemoveAtSwap(LeaseIndex);
+				bReleasedTokens = true;
+			}
+			else
+			{
+				NextExpireTime = FMath::Min(NextExpireTime, Lease.ExpireTime);
+			}
+		}
+
+		if (bReleasedTokens)
+		{
+			GrantWaiters(Pool, Granted);
+		}
+	}
+
+	NotifyResolved(Granted, true);
+}
+
+void UMyAttackTokenSubsystem::RegisterTarget(AActor* Target, const int32 Capacity)
+{
+	if (!Target)
+	{
+		return;
+	}
+
+	FAttackTokenPool& Pool = Pools.FindOrAdd(Target);
+	Pool.Available += Capacity - Pool.Capacity;
+	Pool.Capacity = Capacity;
+
+	FResolvedCallbacks Granted;
+	GrantWaiters(Pool, Granted);
+	NotifyResolved(Granted, true);
+}
+
+void UMyAttackTokenSubsystem::UnregisterTarget(const AActor* Target)
+{
+	FAttackTokenPool Pool;
+	if (!Target || !Pools.RemoveAndCopyValue(Target, Pool))
+	{
+		return;
+	}
+
+	FResolvedCallbacks Dropped;
+	for (FAttackTokenWaiter& Waiter : Pool.Waiters)
+	{
+		Dropped.Add(MoveTemp(Waiter.OnResolved));
+	}
+
+	NotifyResolved(Dropped, false);
+}
+
+bool UMyAttackTokenSubsystem::RequestToken(const AActor* Target, AActor* Attacker, const int32 Amount)
+{
+	if (!Target || !Attacker)
+	{
+		return false;
+	}
+
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderRequestToken);
+	INC_DWORD_STAT(STAT_RaiderTokenRequests);
+
+	FAttackTokenPool* Pool = Pools.Find(Target);
+	if (!Pool)
+	{
+		return true;
+	}
+
+	// Holders keep their tokens, same as before the leases
+	const double ExpireTime = GetWorld()->GetTimeSeconds() + CVarAttackTokenLeaseTime.GetValueOnGameThread();
+	if (FAttackTokenLease* Lease = Pool->Leases.FindByPredicate([Attacker](const FAttackTokenLease& Lease) { return Lease.Attacker == Attacker; }))
+	{
+		Lease->ExpireTime = ExpireTime;
+		return true;
+	}
+
+	// Waiting attackers are served first
+	if (Pool->Waiters.Num() > 0 || Pool->Available < Amount)
+	{
+		return false;
+	}
+
+	GrantLease(*Pool, Attacker, Amount);
+	return true;
+}
+
+EAttackTokenRequestResult UMyAttackTokenSubsystem::RequestTokenOrWait(const AActor* Target, AActor* Attacker, const int32 Amount,
+                                                                       const int32 Priority, FOnAttackTokenResolved&& OnResolved)
+{
+	if (!Target || !Attacker)
+	{
+		return EAttackTokenRequestResult::Denied;
+	}
+
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderRequestTokenOrWait);
+
+	if (RequestToken(Target, Attacker, Amount))
+	{
+		return EAttackTokenRequestResult::Granted;
+	}
+
+	FAttackTokenPool& Pool = Pools.FindChecked(Target);
+	if (Amount > Pool.Capacity)
+	{
+		return EAttackTokenRequestResult::Denied;
+	}
+
+	// A new request replaces the previous one of the attacker
+	RemoveWaiter(Pool, Attacker);
+
+	FAttackTokenWaiter Waiter;
+	Waiter.Attacker = Attacker;
+	Waiter.Amount = Amount;
+	Waiter.Priority = Priority;
+	Waiter.OnResolved = MoveTemp(OnResolved);
+
+	// Behind every waiter with the same or a higher priority
+	const int32 InsertIndex = Algo::UpperBound(Pool.Waiters, Waiter, [](const FAttackTokenWaiter& A, const FAttackTokenWaiter& B)
+	{
+		return A.Priority > B.Priority;
+	});
+	Pool.Waiters.Insert(MoveTemp(Waiter), InsertIndex);
+
+	return EAttackTokenRequestResult::Queued;
+}
+
+void UMyAttackTokenSubsystem::ReturnToken(const AActor* Target, const AActor* Attacker)
+{
+	FAttackTokenPool* Pool = Target ? Pools.Find(Target) : nullptr;
+	if (!Pool || !RemoveLease(*Pool, Attacker))
+	{
+		return;
+	}
+
+	FResolvedCallbacks Granted;
+	GrantWaiters(*Pool, Granted);
+	NotifyResolved(Granted, true);
+}
+
+void UMyAttackTokenSubsystem::CancelWait(const AActor* Target, const AActor* Attacker)
+{
+	if (FAttackTokenPool* Pool = Target ? Pools.Find(Target) : nullptr)
+	{
+		RemoveWaiter(*Pool, Attacker);
+
+		// The cancelled waiter may have blocked smaller requests behind it
+		FResolvedCallbacks Granted;
+		GrantWaiters(*Pool, Granted);
+		NotifyResolved(Granted, true);
+	}
+}
+
+void UMyAttackTokenSubsystem::ReleaseAttacker(const AActor* Attacker)
+{
+	if (!Attacker)
+	{
+		return;
+	}
+
+	FResolvedCallbacks Granted;
+	for (TPair<TObjectKey<AActor>, FAttackTokenPool>& TargetPool : Pools)
+	{
+		FAttackTokenPool& Pool = TargetPool.Value;
+		RemoveWaiter(Pool, Attacker);
+		if (RemoveLease(Pool, Attacker))
+		{
+			GrantWaiters(Pool, Granted);
+		}
+	}
+
+	NotifyResolved(Granted, true);
+}
+
+bool UMyAttackTokenSubsystem::HasToken(const AActor* Target, const AActor* Attacker) const
+{
+	const FAttackTokenPool* Pool = Target ? Pools.Find(Target) : nullptr;
+	return Pool && Pool->Leases.ContainsByPredicate([Attacker](const FAttackTokenLease& Lease) { return Lease.Attacker == Attacker; });
+}
+
+void UMyAttackTokenSubsystem::GrantLease(FAttackTokenPool& Pool, AActor* Attacker, const int32 Amount)
+{
+	INC_DWORD_STAT(STAT_RaiderTokenGrants);
+
+	FAttackTokenLease& Lease = Pool.Leases.AddDefaulted_GetRef();
+	Lease.Attacker = Attacker;
+	Lease.Amount = Amount;
+	Lease.ExpireTime = GetWorld()->GetTimeSeconds() + CVarAttackTokenLeaseTime.GetValueOnGameThread();
+
+	Pool.Available -= Amount;
+	NextExpireTime = FMath::Min(NextExpireTime, Lease.ExpireTime);
+}
+
+bool UMyAttackTokenSubsystem::RemoveLease(FAttackTokenPool& Pool, const AActor* Attacker)
+{
+	const int32 LeaseIndex = Pool.Leases.IndexOfByPredicate([Attacker](const FAttackTokenLease& Lease) { return Lease.Attacker == Attacker; });
+	if (LeaseIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	Pool.Available += Pool.Leases[LeaseIndex].Amount;
+	Pool.Leases.RemoveAtSwap(LeaseIndex);
+	return true;
+}
+
+void UMyAttackTokenSubsystem::RemoveWaiter(FAttackTokenPool& Pool, const AActor* Attacker)
+{
+	const int32 WaiterIndex = Pool.Waiters.IndexOfByPredicate([Attacker](const FAttackTokenWaiter& Waiter) { return Waiter.Attacker == Attacker; });
+	if (WaiterIndex != INDEX_NONE)
+	{
+		Pool.Waiters.RemoveAt(WaiterIndex);
+	}
+}
+
+void UMyAttackTokenSubsystem::GrantWaiters(FAttackTokenPool& Pool, FResolvedCallbacks& OutGranted)
+{
+	int32 NumServed = 0;
+	for (; NumServed < Pool.Waiters.Num(); ++NumServed)
+	{
+		FAttackTokenWaiter& Waiter = Pool.Waiters[NumServed];
+		AActor* Attacker = Waiter.Attacker.Get();
+		if (!Attacker)
+		{
+			continue;
+		}
+
+		// The head of the queue blocks everyone behind it
+		if (Pool.Available < Waiter.Amount)
+		{
+			break;
+		}
+
+		GrantLease(Pool, Attacker, Waiter.Amount);
+		OutGranted.Add(MoveTemp(Waiter.OnResolved));
+	}
+
+	Pool.Waiters.RemoveAt(0, NumServed);
+}
+
+void UMyAttackTokenSubsystem::NotifyResolved(FResolvedCallbacks& Callbacks, const bool bGranted)
+{
+	for (FOnAttackTokenResolved& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(bGranted);
+	}
+
+	Callbacks.Reset();
+}
@@ -0,0 +1,279 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyCombatQuerySubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Components/MyCombatComponent.h"
+#include "RaiderStats.h"
+#include "Subsystems/MyCombatantGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("ResolvePendingRequestsFromGrid"), STAT_RaiderResolvePendingRequestsFromGrid, STATGROUP_RaiderCombat);
+DECLARE_CYCLE_STAT(TEXT("SubmitPendingRequests"), STAT_RaiderSubmitPendingRequests, STATGROUP_RaiderCombat);
+DECLARE_CYCLE_STAT(TEXT("QueryHitActors"), STAT_RaiderQueryHitActors, STATGROUP_RaiderCombat);
+DECLARE_CYCLE_STAT(TEXT("ApplyOverlaps"), STAT_RaiderApplyOverlaps, STATGROUP_RaiderCombat);
+
+static TAutoConsoleVariable<bool> CVarAsyncHitQueries(
+	TEXT("Raider.Combat.AsyncHitQueries"),
+	true,
+	TEXT("Batch melee hit queries into async overlaps that are resolved at the start of the next frame."));
+
+// The local player issues nearly all combo and spin hits, so they are batched as well unless this is turned on
+static TAutoConsoleVariable<bool> CVarImmediateLocalPlayerHits(
+	TEXT("Raider.Combat.ImmediateLocalPlayerHits"),
+	false,
+	TEXT("Resolve hit queries issued by the local player immediately instead of batching them."));
+
+// Batched requests are answered from the grid by default, the async overlaps run when it is turned off
+static TAutoConsoleVariable<bool> CVarUseCombatantGrid(
+	TEXT("Raider.Combat.UseCombatantGrid"),
+	true,
+	TEXT("Answer melee hit queries from the combatant grid instead of the physics scene."));
+
+void UMyCombatQuerySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CombatantGrid = Collection.InitializeDependency<UMyCombatantGridSubsystem>();
+	OverlapDelegate.BindUObject(this, &UMyCombatQuerySubsystem::OnOverlapCompleted);
+}
+
+void UMyCombatQuerySubsystem::Deinitialize()
+{
+	OverlapDelegate.Unbind();
+	PendingRequests.Empty();
+	InFlightRequests.Empty();
+
+	Super::Deinitialize();
+}
+
+void UMyCombatQuerySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Last frame's batch was delivered by the world before any tick ran, start the next one
+	InFlightRequests.Reset();
+
+	if (ShouldUseCombatantGrid())
+	{
+		ResolvePendingRequestsFromGrid();
+	}
+	else
+	{
+		SubmitPendingRequests();
+	}
+}
+
+TStatId UMyCombatQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMyCombatQuerySubsystem, STATGROUP_Tickables);
+}
+
+void UMyCombatQuerySubsystem::QueueHitQuery(UMyCombatComponent* Instigator, const FVector& Start, const FVector& End,
+                                            const float Radius, const FSDamageInfo& DamageInfo)
+{
+	if (!Instigator)
+	{
+		return;
+	}
+
+	FCombatHitRequest Request;
+	Request.Instigator = Instigator;
+	Request.Start = Start;
+	Request.End = End;
+	Request.Radius = Radius;
+	Request.DamageInfo = DamageInfo;
+
+	if (!CVarAsyncHitQueries.GetValueOnGameThread() ||
+		(CVarImmediateLocalPlayerHits.GetValueOnGameThread() && IsLocalPlayerRequest(Request)))
+	{
+		ResolveImmediately(Request);
+		return;
+	}
+
+	PendingRequests.Add(MoveTemp(Request));
+}
+
+bool UMyCombatQuerySubsystem::ShouldUseCombatantGrid() const
+{
+	return CVarUseCombatantGrid.GetValueOnGameThread() && CombatantGrid;
+}
+
+void UMyCombatQuerySubsystem::ResolvePendingRequestsFromGrid()
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderResolvePendingRequestsFromGrid);
+
+	// Damage reactions may queue new requests, those go to the next batch
+	Swap(InFlightRequests, PendingRequests);
+	INC_DWORD_STAT_BY(STAT_RaiderHitsQueried, InFlightRequests.Num());
+
+	for (const FCombatHitRequest& Request : InFlightRequests)
+	{
+		ApplyGridHits(Request);
+	}
+
+	InFlightRequests.Reset();
+}
+
+void UMyCombatQuerySubsystem::ApplyGridHits(const FCombatHitRequest& Request)
+{
+	UMyCombatComponent* Instigator = Request.Instigator.Get();
+	if (!Instigator)
+	{
+		return;
+	}
+
+	// The grid hands out the combat components, the damage path needs no component search per hit
+	ScratchCombatComponents.Reset();
+	if (CombatantGrid->QueryCapsule(Request.Start, Request.End, Request.Radius, Instigator->GetOwner(), ScratchCombatComponents) > 0)
+	{
+		FDamagedActorArray DamagedActors;
+		Instigator->DamageAllNoneTeamMembers(MakeArrayView(ScratchCombatComponents), Request.DamageInfo, DamagedActors);
+	}
+}
+
+void UMyCombatQuerySubsystem::SubmitPendingRequests()
+{
+	UWorld* World = GetWorld();
+	if (!World || PendingRequests.Num() == 0)
+	{
+		return;
+	}
+
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderSubmitPendingRequests);
+
+	// Keep the submitted batch alive until its results arrive, reuse the old allocation for the next frame
+	Swap(InFlightRequests, PendingRequests);
+	INC_DWORD_STAT_BY(STAT_RaiderHitsQueried, InFlightRequests.Num());
+
+	const FCollisionObjectQueryParams ObjectQueryParams(ECC_Pawn);
+
+	for (int32 Index = 0; Index < InFlightRequests.Num(); ++Index)
+	{
+		const FCombatHitRequest& Request = InFlightRequests[Index];
+		const UMyCombatComponent* Instigator = Request.Instigator.Get();
+		if (!Instigator)
+		{
+			continue;
+		}
+
+		FVector Center;
+		FQuat Rotation;
+		const FCollisionShape Shape = MakeSweptSphereShape(Request, Center, Rotation);
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatHitQuery), false, Instigator->GetOwner());
+
+		World->AsyncOverlapByObjectType(Center, Rotation, ObjectQueryParams, Shape, QueryParams, &OverlapDelegate, Index);
+	}
+}
+
+int32 UMyCombatQuerySubsystem::QueryHitActors(const UMyCombatComponent* Instigator, const FVector& Start, const FVector& End,
+                                              const float Radius, TArray<AActor*>& OutActors)
+{
+	UWorld* World = GetWorld();
+	if (!World || !Instigator)
+	{
+		return 0;
+	}
+
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderQueryHitActors);
+	INC_DWORD_STAT(STAT_RaiderHitsQueried);
+
+	if (ShouldUseCombatantGrid())
+	{
+		return CombatantGrid->QueryCapsule(Start, End, Radius, Instigator->GetOwner(), OutActors);
+	}
+
+	FCombatHitRequest Request;
+	Request.Start = Start;
+	Request.End = End;
+	Request.Radius = Radius;
+
+	FVector Center;
+	FQuat Rotation;
+	const FCollisionShape Shape = MakeSweptSphereShape(Request, Center, Rotation);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatHitQuery), false, Instigator->GetOwner());
+
+	ScratchOverlaps.Reset();
+	World->OverlapMultiByObjectType(ScratchOverlaps, Center, Rotation, FCollisionObjectQueryParams(ECC_Pawn), Shape, QueryParams);
+
+	const int32 NumBefore = OutActors.Num();
+	for (const FOverlapResult& Overlap : ScratchOverlaps)
+	{
+		if (AActor* HitActor = Overlap.GetActor())
+		{
+			OutActors.AddUnique(HitActor);
+		}
+	}
+
+	return OutActors.Num() - NumBefore;
+}
+
+void UMyCombatQuerySubsystem::ResolveImmediately(const FCombatHitRequest& Request)
+{
+	if (ShouldUseCombatantGrid())
+	{
+		ApplyGridHits(Request);
+		return;
+	}
+
+	ScratchActors.Reset();
+	QueryHitActors(Request.Instigator.Get(), Request.Start, Request.End, Request.Radius, ScratchActors);
+	ApplyScratchActors(Request);
+}
+
+void UMyCombatQuerySubsystem::OnOverlapCompleted(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum)
+{
+	if (InFlightRequests.IsValidIndex(OverlapDatum.UserData))
+	{
+		ApplyOverlaps(InFlightRequests[OverlapDatum.UserData], OverlapDatum.OutOverlaps);
+	}
+}
+
+void UMyCombatQuerySubsystem::ApplyOverlaps(const FCombatHitRequest& Request, const TArray<FOverlapResult>& Overlaps)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderApplyOverlaps);
+
+	ScratchActors.Reset();
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		if (AActor* HitActor = Overlap.GetActor())
+		{
+			ScratchActors.Add(HitActor);
+		}
+	}
+
+	ApplyScratchActors(Request);
+}
+
+void UMyCombatQuerySubsystem::ApplyScratchActors(const FCombatHitRequest& Request)
+{
+	UMyCombatComponent* Instigator = Request.Instigator.Get();
+	if (!Instigator || ScratchActors.Num() == 0)
+	{
+		return;
+	}
+
+	FDamagedActorArray DamagedActors;
+	Instigator->DamageAllNoneTeamMembers(MakeArrayView(ScratchActors), Request.DamageInfo, DamagedActors);
+}
+
+bool UMyCombatQuerySubsystem::IsLocalPlayerRequest(const FCombatHitRequest& Request)
+{
+	const UMyCombatComponent* Instigator = Request.Instigator.Get();
+	const APawn* OwnerPawn = Instigator ? Cast<APawn>(Instigator->GetOwner()) : nullptr;
+
+	return OwnerPawn && OwnerPawn->IsPlayerControlled() && OwnerPawn->IsLocallyControlled();
+}
+
+FCollisionShape UMyCombatQuerySubsystem::MakeSweptSphereShape(const FCombatHitRequest& Request, FVector& OutCenter, FQuat& OutRotation)
+{
+	// A sphere swept along a segment covers exactly a capsule aligned with that segment
+	const FVector Sweep = Request.End - Request.Start;
+	const float HalfLength = Sweep.Size() * 0.5f;
+
+	OutCenter = Request.Start + Sweep * 0.5f;
+	OutRotation = HalfLength > UE_KINDA_SMALL_NUMBER ? FRotationMatrix::MakeFromZ(Sweep).ToQuat() : FQuat::Identity;
+
+	return FCollisionShape::MakeCapsule(Request.Radius, HalfLength + Request.Radius);
+}
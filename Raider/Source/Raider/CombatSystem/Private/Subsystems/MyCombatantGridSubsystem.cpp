@@ -0,0 +1,303 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyCombatantGridSubsystem.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/MyCombatComponent.h"
+#include "GameFramework/Actor.h"
+#include "Subsystems/MyTeamRegistrySubsystem.h"
+
+static TAutoConsoleVariable<float> CVarCombatantGridCellSize(
+	TEXT("Raider.Combat.GridCellSize"),
+	500.0f,
+	TEXT("Edge length of a combatant grid cell. Read when the world starts."));
+
+void UMyCombatantGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TeamRegistry = Collection.InitializeDependency<UMyTeamRegistrySubsystem>();
+	CellSize = FMath::Max(CVarCombatantGridCellSize.GetValueOnGameThread(), 100.0f);
+}
+
+void UMyCombatantGridSubsystem::Deinitialize()
+{
+	for (const FCombatantGridEntry& Entry : Combatants)
+	{
+		if (UCapsuleComponent* Capsule = Entry.Capsule.Get())
+		{
+			Capsule->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+		}
+	}
+
+	Combatants.Empty();
+	Cells.Empty();
+	CombatantIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UMyCombatantGridSubsystem::RegisterCombatant(UMyCombatComponent* CombatComponent)
+{
+	AActor* Combatant = CombatComponent ? CombatComponent->GetOwner() : nullptr;
+	if (!Combatant || CombatantIndices.Contains(Combatant))
+	{
+		return;
+	}
+
+	UCapsuleComponent* Capsule = Cast<UCapsuleComponent>(Combatant->GetRootComponent());
+	if (!Capsule)
+	{
+		Capsule = Combatant->FindComponentByClass<UCapsuleComponent>();
+	}
+
+	if (!Capsule)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s has no capsule and cannot be added to the combatant grid"), *Combatant->GetName());
+		return;
+	}
+
+	FCombatantGridEntry Entry;
+	Entry.Actor = Combatant;
+	Entry.CombatComponent = CombatComponent;
+	Entry.Capsule = Capsule;
+	Entry.Location = Capsule->GetComponentLocation();
+	Entry.Radius = Capsule->GetScaledCapsuleRadius();
+	Entry.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	Entry.TeamId = CombatComponent->GetTeamId();
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 CombatantIndex = Combatants.Add(MoveTemp(Entry));
+	FCombatantGridEntry& AddedEntry = Combatants[CombatantIndex];
+	AddedEntry.TransformUpdatedHandle = Capsule->TransformUpdated.AddUObject(this, &UMyCombatantGridSubsystem::OnCombatantMoved, CombatantIndex);
+
+	Cells.FindOrAdd(AddedEntry.Cell).Add(CombatantIndex);
+	CombatantIndices.Add(Combatant, CombatantIndex);
+	MaxCombatantRadius = FMath::Max(MaxCombatantRadius, AddedEntry.Radius);
+}
+
+void UMyCombatantGridSubsystem::UnregisterCombatant(const AActor* Combatant)
+{
+	int32 CombatantIndex = INDEX_NONE;
+	if (!Combatant || !CombatantIndices.RemoveAndCopyValue(Combatant, CombatantIndex))
+	{
+		return;
+	}
+
+	const FCombatantGridEntry& Entry = Combatants[CombatantIndex];
+	if (UCapsuleComponent* Capsule = Entry.Capsule.Get())
+	{
+		Capsule->TransformUpdated.Remove(Entry.TransformUpdatedHandle);
+	}
+
+	if (TArray<int32>* CellCombatants = Cells.Find(Entry.Cell))
+	{
+		CellCombatants->RemoveSingleSwap(CombatantIndex);
+		if (CellCombatants->Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+
+	Combatants.RemoveAt(CombatantIndex);
+}
+
+void UMyCombatantGridSubsystem::OnCombatantMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags,
+                                                 ETeleportType Teleport, const int32 CombatantIndex)
+{
+	if (!Combatants.IsValidIndex(CombatantIndex))
+	{
+		return;
+	}
+
+	FCombatantGridEntry& Entry = Combatants[CombatantIndex];
+	Entry.Location = UpdatedComponent->GetComponentLocation();
+
+	// Only touch the cell map when the combatant crosses a cell border
+	const FIntPoint NewCell = GetCell(Entry.Location);
+	if (NewCell == Entry.Cell)
+	{
+		return;
+	}
+
+	if (TArray<int32>* OldCellCombatants = Cells.Find(Entry.Cell))
+	{
+		OldCellCombatants->RemoveSingleSwap(CombatantIndex);
+		if (OldCellCombatants->Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+
+	Cells.FindOrAdd(NewCell).Add(CombatantIndex);
+	Entry.Cell = NewCell;
+}
+
+FIntPoint UMyCombatantGridSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+FBox2D UMyCombatantGridSubsystem::GetSweptSphereBounds(const FVector& Start, const FVector& End, const float Radius)
+{
+	FBox2D Bounds(FVector2D(Start), FVector2D(Start));
+	Bounds += FVector2D(End);
+	return Bounds.ExpandBy(Radius);
+}
+
+bool UMyCombatantGridSubsystem::IsTouchingSweptSphere(const FCombatantGridEntry& Entry, const FVector& Start, const FVector& End, const float Radius)
+{
+	const FVector SegmentOffset(0.0f, 0.0f, FMath::Max(Entry.HalfHeight - Entry.Radius, 0.0f));
+
+	FVector ClosestOnSweep;
+	FVector ClosestOnCapsule;
+	FMath::SegmentDistToSegmentSafe(Start, End, Entry.Location - SegmentOffset, Entry.Location + SegmentOffset, ClosestOnSweep, ClosestOnCapsule);
+
+	return FVector::DistSquared(ClosestOnSweep, ClosestOnCapsule) <= FMath::Square(Radius + Entry.Radius);
+}
+
+template <typename VisitorType>
+void UMyCombatantGridSubsystem::ForEachHostileCombatant(const FBox2D& Bounds, const AActor* Instigator, VisitorType&& Visitor) const
+{
+	const int32* InstigatorIndex = Instigator ? CombatantIndices.Find(Instigator) : nullptr;
+	const uint8* InstigatorTeamId = InstigatorIndex ? &Combatants[*InstigatorIndex].TeamId : nullptr;
+
+	// Combatants are stored by their center, widen the bounds so capsules overlapping a border are found
+	const FIntPoint MinCell = GetCell(FVector(Bounds.Min - FVector2D(MaxCombatantRadius), 0.0f));
+	const FIntPoint MaxCell = GetCell(FVector(Bounds.Max + FVector2D(MaxCombatantRadius), 0.0f));
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			const TArray<int32>* CellCombatants = Cells.Find(FIntPoint(CellX, CellY));
+			if (!CellCombatants)
+			{
+				continue;
+			}
+
+			for (const int32 CombatantIndex : *CellCombatants)
+			{
+				const FCombatantGridEntry& Entry = Combatants[CombatantIndex];
+
+				// Skip combatants the instigator is not hostile to
+				if (InstigatorTeamId && TeamRegistry->GetAttitude(*InstigatorTeamId, Entry.TeamId) != ETeamAttitude::Hostile)
+				{
+					continue;
+				}
+
+				AActor* Actor = Entry.Actor.Get();
+				const UCapsuleComponent* Capsule = Entry.Capsule.Get();
+				if (!Actor || Actor == Instigator || !Capsule)
+				{
+					continue;
+				}
+
+				// Dead combatants disable their capsule collision, same as the physics traces did
+				if (!Capsule->IsCollisionEnabled())
+				{
+					continue;
+				}
+
+				Visitor(Entry, Actor);
+			}
+		}
+	}
+}
+
+int32 UMyCombatantGridSubsystem::QuerySphere(const FVector& Center, const float Radius, const AActor* Instigator, TArray<AActor*>& OutActors) const
+{
+	const int32 NumBefore = OutActors.Num();
+	const FVector2D Center2D(Center);
+	const FBox2D Bounds(Center2D - FVector2D(Radius), Center2D + FVector2D(Radius));
+
+	ForEachHostileCombatant(Bounds, Instigator, [&](const FCombatantGridEntry& Entry, AActor* Actor)
+	{
+		const FVector SegmentOffset(0.0f, 0.0f, FMath::Max(Entry.HalfHeight - Entry.Radius, 0.0f));
+		const float Distance = FMath::PointDistToSegment(Center, Entry.Location - SegmentOffset, Entry.Location + SegmentOffset);
+
+		if (Distance <= Radius + Entry.Radius)
+		{
+			OutActors.Add(Actor);
+		}
+	});
+
+	return OutActors.Num() - NumBefore;
+}
+
+int32 UMyCombatantGridSubsystem::QueryCapsule(const FVector& Start, const FVector& End, const float Radius, const AActor* Instigator, TArray<AActor*>& OutActors) const
+{
+	const int32 NumBefore = OutActors.Num();
+
+	ForEachHostileCombatant(GetSweptSphereBounds(Start, End, Radius), Instigator, [&](const FCombatantGridEntry& Entry, AActor* Actor)
+	{
+		if (IsTouchingSweptSphere(Entry, Start, End, Radius))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+
+	return OutActors.Num() - NumBefore;
+}
+
+int32 UMyCombatantGridSubsystem::QueryCapsule(const FVector& Start, const FVector& End, const float Radius, const AActor* Instigator,
+                                              TArray<UMyCombatComponent*>& OutCombatComponents) const
+{
+	const int32 NumBefore = OutCombatComponents.Num();
+
+	ForEachHostileCombatant(GetSweptSphereBounds(Start, End, Radius), Instigator, [&](const FCombatantGridEntry& Entry, AActor* Actor)
+	{
+		UMyCombatComponent* CombatComponent = Entry.CombatComponent.Get();
+		if (CombatComponent && IsTouchingSweptSphere(Entry, Start, End, Radius))
+		{
+			OutCombatComponents.Add(CombatComponent);
+		}
+	});
+
+	return OutCombatComponents.Num() - NumBefore;
+}
+
+int32 UMyCombatantGridSubsystem::QueryArc(const FVector& Origin, const FVector& Direction, const float Radius, const float HalfAngleDegrees,
+                                          const AActor* Instigator, TArray<AActor*>& OutActors) const
+{
+	const int32 NumBefore = OutActors.Num();
+	const FVector2D Origin2D(Origin);
+	const FVector2D Direction2D = FVector2D(Direction).GetSafeNormal();
+	const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(HalfAngleDegrees));
+	const FBox2D Bounds(Origin2D - FVector2D(Radius), Origin2D + FVector2D(Radius));
+
+	ForEachHostileCombatant(Bounds, Instigator, [&](const FCombatantGridEntry& Entry, AActor* Actor)
+	{
+		const FVector2D ToCombatant = FVector2D(Entry.Location) - Origin2D;
+		const float Distance = ToCombatant.Size();
+
+		if (Distance > Radius + Entry.Radius)
+		{
+			return;
+		}
+
+		// Combatants standing on the origin are always inside the arc
+		if (Distance <= Entry.Radius || FVector2D::DotProduct(ToCombatant / Distance, Direction2D) >= CosHalfAngle)
+		{
+			OutActors.Add(Actor);
+		}
+	});
+
+	return OutActors.Num() - NumBefore;
+}
+
+TArray<AActor*> UMyCombatantGridSubsystem::K2_QuerySphere(const FVector& Center, const float Radius, const AActor* Instigator) const
+{
+	TArray<AActor*> Actors;
+	QuerySphere(Center, Radius, Instigator, Actors);
+	return Actors;
+}
+
+TArray<AActor*> UMyCombatantGridSubsystem::K2_QueryArc(const FVector& Origin, const FVector& Direction, const float Radius,
+                                                      const float HalfAngleDegrees, const AActor* Instigator) const
+{
+	TArray<AActor*> Actors;
+	QueryArc(Origin, Direction, Radius, HalfAngleDegrees, Instigator, Actors);
+	return Actors;
+}
@@ -0,0 +1,168 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyDamagePipelineSubsystem.h"
+
+#include "Benchmark/RaiderBenchmarkCounters.h"
+#include "Components/MyCombatComponent.h"
+#include "Engine/World.h"
+#include "Interfaces/MyCombatInterface.h"
+#include "RaiderStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("FlushDamage"), STAT_RaiderFlushDamage, STATGROUP_RaiderCombat);
+
+static TAutoConsoleVariable<bool> CVarDeferredDamage(
+	TEXT("Raider.Combat.DeferredDamage"),
+	true,
+	TEXT("Queue damage and apply it per target at the end of the frame instead of inside the attack notify."));
+
+/** Events both queues hold without growing, a crowd of enemies landing hits in the same frame */
+static constexpr int32 ReservedDamageEvents = 256;
+
+void UMyDamagePipelineSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UMyDamagePipelineSubsystem::OnWorldPostActorTick);
+
+	// The queues are swapped and reset, never shrunk, so queuing a hit doesn't allocate
+	PendingEvents.Reserve(ReservedDamageEvents);
+	ResolvingEvents.Reserve(ReservedDamageEvents);
+}
+
+void UMyDamagePipelineSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PendingEvents.Empty();
+	ResolvingEvents.Empty();
+
+	Super::Deinitialize();
+}
+
+void UMyDamagePipelineSubsystem::QueueDamage(AActor* Target, AActor* Attacker, const FSDamageInfo& DamageInfo)
+{
+	QueueDamage(Target, Target ? Target->FindComponentByClass<UMyCombatComponent>() : nullptr, Attacker, DamageInfo);
+}
+
+void UMyDamagePipelineSubsystem::QueueDamage(AActor* Target, UMyCombatComponent* TargetCombatComponent, AActor* Attacker,
+                                             const FSDamageInfo& DamageInfo)
+{
+	if (!Target || !Target->GetClass()->ImplementsInterface(UMyCombatInterface::StaticClass()))
+	{
+		return;
+	}
+
+	// Damage is applied by the server, clients receive the health and the reaction through replication
+	if (!Target->HasAuthority())
+	{
+		return;
+	}
+
+	++FRaiderBenchmarkCounters::NumDamageEvents;
+
+	if (!CVarDeferredDamage.GetValueOnGameThread())
+	{
+		ApplyDamage(Target, TargetCombatComponent, Attacker, DamageInfo);
+		return;
+	}
+
+	FQueuedDamageEvent& Event = PendingEvents.AddDefaulted_GetRef();
+	Event.Target = Target;
+	Event.TargetCombatComponent = TargetCombatComponent;
+	Event.Attacker = Attacker;
+	Event.DamageInfo = DamageInfo;
+	Event.TargetId = Target->GetUniqueID();
+}
+
+void UMyDamagePipelineSubsystem::FlushDamage()
+{
+	if (PendingEvents.Num() == 0)
+	{
+		return;
+	}
+
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderFlushDamage);
+
+	// Damage reactions may queue new events, those are applied next frame
+	Swap(ResolvingEvents, PendingEvents);
+
+	// Stable sort keeps the queue order of hits on the same target with the same defense flags
+	ResolvingEvents.StableSort([](const FQueuedDamageEvent& A, const FQueuedDamageEvent& B)
+	{
+		return A.TargetId != B.TargetId ? A.TargetId < B.TargetId : GetDefenseKey(A.DamageInfo) < GetDefenseKey(B.DamageInfo);
+	});
+
+	int32 FirstIndex = 0;
+	while (FirstIndex < ResolvingEvents.Num())
+	{
+		const FQueuedDamageEvent& FirstEvent = ResolvingEvents[FirstIndex];
+		const uint8 DefenseKey = GetDefenseKey(FirstEvent.DamageInfo);
+		FSDamageInfo MergedDamage = FirstEvent.DamageInfo;
+		AActor* Attacker = FirstEvent.Attacker.Get();
+		float StrongestAmount = FirstEvent.DamageInfo.Amount;
+
+		int32 EndIndex = FirstIndex + 1;
+		for (; EndIndex < ResolvingEvents.Num() && ResolvingEvents[EndIndex].TargetId == FirstEvent.TargetId &&
+		       GetDefenseKey(ResolvingEvents[EndIndex].DamageInfo) == DefenseKey; ++EndIndex)
+		{
+			const FQueuedDamageEvent& Event = ResolvingEvents[EndIndex];
+			MergeDamage(MergedDamage, Event.DamageInfo);
+
+			// The strongest hit decides the damage type and the reported attacker
+			if (Event.DamageInfo.Amount > StrongestAmount)
+			{
+				StrongestAmount = Event.DamageInfo.Amount;
+				MergedDamage.DamageType = Event.DamageInfo.DamageType;
+				if (AActor* EventAttacker = Event.Attacker.Get())
+				{
+					Attacker = EventAttacker;
+				}
+			}
+		}
+
+		// The target may have been destroyed by damage applied earlier in the batch
+		if (AActor* Target = FirstEvent.Target.Get())
+		{
+			ApplyDamage(Target, FirstEvent.TargetCombatComponent.Get(), Attacker, MergedDamage);
+		}
+
+		FirstIndex = EndIndex;
+	}
+
+	ResolvingEvents.Reset();
+}
+
+void UMyDamagePipelineSubsystem::ApplyDamage(AActor* Target, UMyCombatComponent* TargetCombatComponent, AActor* Attacker,
+                                             const FSDamageInfo& DamageInfo)
+{
+	INC_DWORD_STAT(STAT_RaiderDamageEventsApplied);
+	if (!IMyCombatInterface::Execute_TakeDamage(Target, Attacker, DamageInfo) || Target->GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	if (TargetCombatComponent)
+	{
+		TargetCombatComponent->MulticastDamageApplied(DamageInfo);
+	}
+}
+
+void UMyDamagePipelineSubsystem::MergeDamage(FSDamageInfo& Merged, const FSDamageInfo& DamageInfo)
+{
+	Merged.Amount += DamageInfo.Amount;
+	Merged.DamageReact = FMath::Max(Merged.DamageReact, DamageInfo.DamageReact);
+	Merged.ShouldForceInterrupt |= DamageInfo.ShouldForceInterrupt;
+}
+
+uint8 UMyDamagePipelineSubsystem::GetDefenseKey(const FSDamageInfo& DamageInfo)
+{
+	return (DamageInfo.CanBeBlocked ? 1 : 0) | (DamageInfo.ShouldDamageInvisible ? 2 : 0);
+}
+
+void UMyDamagePipelineSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, const float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		FlushDamage();
+	}
+}
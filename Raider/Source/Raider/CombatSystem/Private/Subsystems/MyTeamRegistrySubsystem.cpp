@@ -0,0 +1,100 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyTeamRegistrySubsystem.h"
+
+#include "GameFramework/Actor.h"
+#include "Settings/MyTeamSettings.h"
+
+void UMyTeamRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	BuildAttitudes();
+}
+
+void UMyTeamRegistrySubsystem::Deinitialize()
+{
+	TeamIds.Empty();
+
+	Super::Deinitialize();
+}
+
+uint8 UMyTeamRegistrySubsystem::RegisterCombatant(const AActor* Combatant, const int32 TeamNumber)
+{
+	const uint8 TeamId = ToTeamId(TeamNumber);
+	if (Combatant)
+	{
+		TeamIds.Add(Combatant, TeamId);
+	}
+	return TeamId;
+}
+
+void UMyTeamRegistrySubsystem::UnregisterCombatant(const AActor* Combatant)
+{
+	TeamIds.Remove(Combatant);
+}
+
+bool UMyTeamRegistrySubsystem::GetTeamId(const AActor* Actor, uint8& OutTeamId) const
+{
+	const uint8* TeamId = Actor ? TeamIds.Find(Actor) : nullptr;
+	if (!TeamId)
+	{
+		return false;
+	}
+
+	OutTeamId = *TeamId;
+	return true;
+}
+
+uint8 UMyTeamRegistrySubsystem::ToTeamId(const int32 TeamNumber)
+{
+	if (TeamNumber < 0 || TeamNumber >= NumTeams)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Team number %d is out of range and was clamped"), TeamNumber);
+	}
+	return static_cast<uint8>(FMath::Clamp(TeamNumber, 0, NumTeams - 1));
+}
+
+bool UMyTeamRegistrySubsystem::GetAttitude(const AActor* Actor, const AActor* OtherActor, ETeamAttitude::Type& OutAttitude) const
+{
+	uint8 TeamId;
+	uint8 OtherTeamId;
+	if (!GetTeamId(Actor, TeamId) || !GetTeamId(OtherActor, OtherTeamId))
+	{
+		return false;
+	}
+
+	OutAttitude = GetAttitude(TeamId, OtherTeamId);
+	return true;
+}
+
+void UMyTeamRegistrySubsystem::SetAttitude(const int32 TeamA, const int32 TeamB, const TEnumAsByte<ETeamAttitude::Type> Attitude)
+{
+	const uint8 TeamIdA = ToTeamId(TeamA);
+	const uint8 TeamIdB = ToTeamId(TeamB);
+
+	Attitudes[TeamIdA * NumTeams + TeamIdB] = Attitude;
+	Attitudes[TeamIdB * NumTeams + TeamIdA] = Attitude;
+}
+
+TEnumAsByte<ETeamAttitude::Type> UMyTeamRegistrySubsystem::K2_GetAttitude(const int32 TeamA, const int32 TeamB) const
+{
+	return GetAttitude(ToTeamId(TeamA), ToTeamId(TeamB));
+}
+
+void UMyTeamRegistrySubsystem::BuildAttitudes()
+{
+	const UMyTeamSettings* TeamSettings = GetDefault<UMyTeamSettings>();
+
+	Attitudes.Init(TeamSettings->DefaultAttitude, NumTeams * NumTeams);
+	for (int32 Team = 0; Team < NumTeams; ++Team)
+	{
+		Attitudes[Team * NumTeams + Team] = TeamSettings->SameTeamAttitude;
+	}
+
+	for (const FTeamAttitudeRule& Rule : TeamSettings->AttitudeRules)
+	{
+		SetAttitude(Rule.TeamA, Rule.TeamB, Rule.Attitude);
+	}
+}
@@ -0,0 +1,117 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Subsystems/MyWeaponPoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "Weapon/WeaponBase.h"
+
+static TAutoConsoleVariable<int32> CVarWeaponPoolMaxPerClass(
+	TEXT("Raider.Combat.WeaponPoolMaxPerClass"),
+	32,
+	TEXT("Maximum number of unequipped weapons kept per weapon class. Released weapons above it are destroyed."));
+
+static FAutoConsoleCommandWithWorld CmdDumpWeaponPoolStats(
+	TEXT("Raider.Combat.DumpWeaponPoolStats"),
+	TEXT("Prints the weapon pool spawn, destroy and reuse counters and rates."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UMyWeaponPoolSubsystem* WeaponPool = World ? World->GetSubsystem<UMyWeaponPoolSubsystem>() : nullptr)
+		{
+			WeaponPool->DumpStats();
+		}
+	}));
+
+void UMyWeaponPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	ResetStats();
+}
+
+void UMyWeaponPoolSubsystem::Deinitialize()
+{
+	PooledWeapons.Empty();
+
+	Super::Deinitialize();
+}
+
+AWeaponBase* UMyWeaponPoolSubsystem::AcquireWeapon(const TSubclassOf<AWeaponBase> WeaponClass, AActor* NewOwner)
+{
+	if (!WeaponClass)
+	{
+		return nullptr;
+	}
+
+	if (TArray<TWeakObjectPtr<AWeaponBase>>* Pool = PooledWeapons.Find(WeaponClass))
+	{
+		while (Pool->Num() > 0)
+		{
+			AWeaponBase* Weapon = Pool->Pop(EAllowShrinking::No).Get();
+			if (!Weapon)
+			{
+				continue;
+			}
+
+			Weapon->SetOwner(NewOwner);
+			Weapon->SetActorHiddenInGame(false);
+			++Stats.NumReused;
+			return Weapon;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = NewOwner;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AWeaponBase* Weapon = GetWorld()->SpawnActor<AWeaponBase>(WeaponClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+	if (Weapon)
+	{
+		++Stats.NumSpawned;
+	}
+	return Weapon;
+}
+
+void UMyWeaponPoolSubsystem::ReleaseWeapon(AWeaponBase* Weapon)
+{
+	if (!IsValid(Weapon))
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AWeaponBase>>& Pool = PooledWeapons.FindOrAdd(Weapon->GetClass());
+	if (Pool.Num() >= CVarWeaponPoolMaxPerClass.GetValueOnGameThread())
+	{
+		GetWorld()->DestroyActor(Weapon);
+		++Stats.NumDestroyed;
+		return;
+	}
+
+	Weapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Weapon->SetActorHiddenInGame(true);
+	Weapon->SetOwner(nullptr);
+
+	Pool.Add(Weapon);
+	++Stats.NumReleased;
+}
+
+void UMyWeaponPoolSubsystem::DumpStats() const
+{
+	const double Minutes = FMath::Max((GetWorld()->GetTimeSeconds() - Stats.StartTime) / 60.0, UE_KINDA_SMALL_NUMBER);
+
+	int32 NumPooled = 0;
+	for (const TPair<TSubclassOf<AWeaponBase>, TArray<TWeakObjectPtr<AWeaponBase>>>& Pool : PooledWeapons)
+	{
+		NumPooled += Pool.Value.Num();
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Weapon pool: %d pooled, %d spawned (%.1f/min), %d destroyed (%.1f/min), %d reused (%.1f/min), %d released"),
+	       NumPooled, Stats.NumSpawned, Stats.NumSpawned / Minutes, Stats.NumDestroyed, Stats.NumDestroyed / Minutes,
+	       Stats.NumReused, Stats.NumReused / Minutes, Stats.NumReleased);
+}
+
+void UMyWeaponPoolSubsystem::ResetStats()
+{
+	Stats = FWeaponPoolStats();
+	Stats.StartTime = GetWorld()->GetTimeSeconds();
+}
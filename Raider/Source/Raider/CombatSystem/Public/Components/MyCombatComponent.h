@@ -5,10 +5,17 @@
 #include "CoreMinimal.h"
 #include "CombatSystemAPI.h"
 #include "Components/ActorComponent.h"
+#include "Interfaces/MyPreloadInterface.h"
 #include "MyCombatComponent.generated.h"
 
 struct FSDamageInfo;
 class AWeaponBase;
+class UMyDamagePipelineSubsystem;
+class UMyMontageDispatcherComponent;
+class UMyTeamRegistrySubsystem;
+
+/** Inline result buffer of the native damage functions, large enough for any melee swing */
+using FDamagedActorArray = TArray<AActor*, TInlineAllocator<64>>;
 
 /** Delegate to notify subscribers when weapon equip process is completed */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnEquipWeaponEnd);
@@ -37,15 +44,22 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDamageBlocked);
  *  =====================================================
  */
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
-class COMBATSYSTEM_API UMyCombatComponent : public UActorComponent
+class COMBATSYSTEM_API UMyCombatComponent : public UActorComponent, public IMyPreloadInterface
 {
 	GENERATED_BODY()
 
 public:
 	UMyCombatComponent();
 
+	/** Adds the weapon classes and the montages */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
+	/** The equip, block and invincibility flags replicate push based, only when the server changes them */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 /**
  *	---------------------------------------------
@@ -53,13 +67,17 @@ protected:
  *  ---------------------------------------------
  */
 public:
-	/** Whether the NPC currently has a weapon equipped */
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
+	/** Whether the NPC currently has a weapon equipped, changed at runtime through SetWeaponEquipped */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_IsWeaponEquipped, Category = "Combat|Weapon")
 	bool IsWeaponEquipped;
 
+	/** Sets whether a weapon is equipped and marks it dirty for replication */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Weapon")
+	void SetWeaponEquipped(bool bEquipped);
+
 	/** The weapon class that can be spawned for the NPC */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
-	TSubclassOf<AWeaponBase> WeaponActorClass;
+	TSoftClassPtr<AWeaponBase> WeaponActorClass;
 
 	/** Reference to the currently equipped weapon */
 	UPROPERTY(BlueprintReadOnly, Category = "Combat|Weapon")
@@ -67,7 +85,7 @@ public:
 
 	/** The shield class that can be spawned for the NPC */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
-	TSubclassOf<AWeaponBase> ShieldActorClass;
+	TSoftClassPtr<AWeaponBase> ShieldActorClass;
 
 	/** Reference to the currently equipped shield */
 	UPROPERTY(BlueprintReadOnly, Category = "Combat|Weapon")
@@ -75,11 +93,11 @@ public:
 
 	/** Animation montage played when equipping a weapon */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
-	TObjectPtr<UAnimMontage> EquipMontage;
+	TSoftObjectPtr<UAnimMontage> EquipMontage;
 
 	/** Animation montage played when unequipping a weapon */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
-	TObjectPtr<UAnimMontage> UnEquipMontage;
+	TSoftObjectPtr<UAnimMontage> UnEquipMontage;
 
 	/** The socket name where the weapon will be attached on the character */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
@@ -89,6 +107,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
 	FName ShieldSocketName;
 
+	/** The socket the weapon is holstered at when unequipped, the weapon goes back to the pool when empty */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
+	FName HolsterSocketName;
+
+	/** Whether the holstered weapon stays visible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Weapon")
+	bool bShowHolsteredWeapon;
+
 	/** Equips the assigned weapon */
 	UFUNCTION(BlueprintCallable, Category = "Combat|Weapon")
 	void EquipWeapon();
@@ -101,6 +127,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Combat|Weapon")
 	void EquipShield();
 
+	/** Returns the weapon and shield to the weapon pool without a montage and clears the attack state, used when the owner is recycled */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Weapon")
+	void ResetCombatState();
+
 protected:
 	/**
 	 *  Attaches the weapon to a specified socket on the character.
@@ -124,6 +154,13 @@ protected:
 	UFUNCTION()
 	void PlayUnEquipMontage(UAnimMontage* AnimMontage);
 
+private:
+	/** Takes a weapon from the weapon pool */
+	AWeaponBase* AcquireWeapon(TSubclassOf<AWeaponBase> WeaponClass) const;
+
+	/** Returns a weapon to the weapon pool and clears the reference */
+	void ReleaseWeapon(TObjectPtr<AWeaponBase>& Weapon) const;
+
 /**
  *	---------------------------------------------
  *  Team
@@ -136,9 +173,74 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Combat|Team")
 	AActor* DamageFirstNoneTeamMembers(const TArray<FHitResult>& HitResult, const FSDamageInfo& DamageInfo);
 
+	/**
+	 *  Damages every non team member in the hits without allocating.
+	 *  Multiple hits on the same actor are collapsed with a per-attack generation stamp.
+	 *  @param HitResult - The hits of the attack
+	 *  @param DamageInfo - The damage applied to every hit non team member
+	 *  @param OutDamagedActors - Receives the damaged actors
+	 *  @return Number of actors added to OutDamagedActors
+	 */
+	int32 DamageAllNoneTeamMembers(TArrayView<const FHitResult> HitResult, const FSDamageInfo& DamageInfo, FDamagedActorArray& OutDamagedActors);
+
+	/**
+	 *  Damages every non team member in the actors without allocating.
+	 *  @param HitActors - The actors found by the attack
+	 *  @param DamageInfo - The damage applied to every hit non team member
+	 *  @param OutDamagedActors - Receives the damaged actors
+	 *  @return Number of actors added to OutDamagedActors
+	 */
+	int32 DamageAllNoneTeamMembers(TArrayView<AActor* const> HitActors, const FSDamageInfo& DamageInfo, FDamagedActorArray& OutDamagedActors);
+
+	/**
+	 *  Damages every non team member among the combat components without allocating.
+	 *  Used by the combatant grid, which already knows the component of every combatant.
+	 *  @param HitCombatComponents - Combat components of the actors found by the attack
+	 *  @param DamageInfo - The damage applied to every hit non team member
+	 *  @param OutDamagedActors - Receives the damaged actors
+	 *  @return Number of actors added to OutDamagedActors
+	 */
+	int32 DamageAllNoneTeamMembers(TArrayView<UMyCombatComponent* const> HitCombatComponents, const FSDamageInfo& DamageInfo, FDamagedActorArray& OutDamagedActors);
+
+	/** Team id of the owner in the team registry, valid while IsTeamRegistered */
+	uint8 GetTeamId() const { return TeamId; }
+
+	/** Whether the owner is registered in the team registry */
+	bool IsTeamRegistered() const { return bIsTeamRegistered; }
+
 private:
+	/** Generation of the last attack that damaged the owner, compared instead of searching the damaged actors */
+	uint32 LastHitGeneration;
+
+	/** Team id of the owner in the team registry */
+	uint8 TeamId;
+
+	/** Whether the owner is registered in the team registry */
+	bool bIsTeamRegistered;
+
+	/** Team registry of the world, cached at BeginPlay so a team check is a single attitude load */
 	UPROPERTY()
-	TArray<AActor*> DamagedActors;
+	TObjectPtr<UMyTeamRegistrySubsystem> TeamRegistry;
+
+	/** Damage pipeline of the world, cached at BeginPlay */
+	UPROPERTY()
+	TObjectPtr<UMyDamagePipelineSubsystem> DamagePipeline;
+
+	/**
+	 *  Damages the actor unless it is a team member or was already damaged by the same attack.
+	 *  @return true if damage was applied
+	 */
+	bool TryDamageActor(AActor* HitActor, UMyCombatComponent* HitCombatComponent, uint32 HitGeneration, const FSDamageInfo& DamageInfo,
+	                    FDamagedActorArray& OutDamagedActors);
+
+	/** Whether the owner is hostile to the other actor, using the cached team ids when both are registered */
+	bool IsHostile(AActor* OtherActor, const UMyCombatComponent* OtherCombatComponent) const;
+
+	/** Sends the damage through the damage pipeline, or applies it directly when there is none */
+	void ApplyDamage(AActor* HitActor, UMyCombatComponent* HitCombatComponent, const FSDamageInfo& DamageInfo) const;
+
+	/** Starts a new attack generation */
+	static uint32 NextHitGeneration();
 
 	UFUNCTION(BlueprintCallable, Category = "Combat|Team")
 	bool IsOnSameTeam(AActor* OwnerActor, AActor* OtherActor) const;
@@ -155,7 +257,7 @@ public:
 	
 	/** Array of attack montages for combo sequence */
 	UPROPERTY(EditDefaultsOnly, Category = "Combat|Attack|Montage")
-	UAnimMontage* AttackMontage;
+	TSoftObjectPtr<UAnimMontage> AttackMontage;
 
 	/** Adjust montage play rate for player */
 	UPROPERTY(EditDefaultsOnly, Category = "Combat|Attack|Montage")
@@ -204,18 +306,18 @@ protected:
 public:
 	/** Animation montage played when blocking the attack */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Defense")
-	TObjectPtr<UAnimMontage> BlockMontage;
+	TSoftObjectPtr<UAnimMontage> BlockMontage;
 	
 	/** Animation montage played when taking hit */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Defense")
-	TObjectPtr<UAnimMontage> TakeHitMontage;
+	TSoftObjectPtr<UAnimMontage> TakeHitMontage;
 	
-	/** Indicates whether the character is invincible */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Defense")
+	/** Indicates whether the character is invincible, changed at runtime through SetInvincible */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Combat|Defense")
 	bool bIsInvincible;
 	
-	/** Indicate whether the character is blocking */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat|Defense")
+	/** Indicate whether the character is blocking, changed at runtime through SetBlocking */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Combat|Defense")
 	bool bIsBlocking;
 
 	/** Indicate whether the damage can be interrupted */
@@ -237,6 +339,22 @@ public:
 	/** Start Blocking the attack */
 	UFUNCTION(BlueprintCallable, Category = "Combat|Defense")
 	void Block();
+
+	/** Sets whether the character is invincible and marks it dirty for replication */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Defense")
+	void SetInvincible(bool bInvincible);
+
+	/** Sets whether the character is blocking and marks it dirty for replication */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Defense")
+	void SetBlocking(bool bBlocking);
+
+	/**
+	 *  Sends damage the server applied to the clients, which replay the reaction. Only the
+	 *  damage info travels, bit-packed by its NetSerialize.
+	 *  @param DamageInfo - The damage applied
+	 */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastDamageApplied(const FSDamageInfo& DamageInfo);
 	
 protected:
 	/**
@@ -328,7 +446,7 @@ protected:
 	void OnTakeHitMontageEnded(UAnimMontage* Montage, bool bInterrupted) const;
 
 	/**
-	 *  Callback function triggered when the blocking montage notify begins
+	 *  Callback function triggered when the blocking montage BlockStart notify begins
 	 *  @param NotifyName - The name of animation montage notifier
 	 *  @param BranchingPointPayload - dditional data passed by the animation system for branching point notifies.
 	 */
@@ -347,4 +465,19 @@ public:
 	/** Broadcast OnAttackEnd */
 	UFUNCTION(Blueprintable, Category = "Combat|Delegate")
 	void TriggerOnAttackEnd();
+
+private:
+	/** Dispatcher playing the montages of the owner, cached at BeginPlay */
+	UPROPERTY()
+	TObjectPtr<UMyMontageDispatcherComponent> MontageDispatcher;
+
+/**
+ *  ---------------------------------------------------------------------
+ *  Replication
+ *  ---------------------------------------------------------------------
+ */
+private:
+	/** Moves the weapon of the client to the hand or the holster, clients spawn and keep their own weapon actors */
+	UFUNCTION()
+	void OnRep_IsWeaponEquipped();
 };
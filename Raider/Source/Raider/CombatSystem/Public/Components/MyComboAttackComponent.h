@@ -5,11 +5,25 @@
 #include "CoreMinimal.h"
 #include "CombatSystemAPI.h"
 #include "Components/ActorComponent.h"
+#include "Interfaces/MyPreloadInterface.h"
+#include "Structs/FAttackHitData.h"
+#include "Structs/FComboAttackData.h"
 #include "MyComboAttackComponent.generated.h"
 
+class UMyMontageDispatcherComponent;
+
+/** A combo input recorded in the input buffer */
+struct FComboInputEvent
+{
+	/** The pressed input */
+	EComboInput Input = EComboInput::None;
+
+	/** Platform time the press was handled, not quantized to the frame start like the world time */
+	double Timestamp = 0.0;
+};
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
-class COMBATSYSTEM_API UMyComboAttackComponent : public UActorComponent
+class COMBATSYSTEM_API UMyComboAttackComponent : public UActorComponent, public IMyPreloadInterface
 {
 	GENERATED_BODY()
 
@@ -17,13 +31,29 @@ public:
 	// Sets default values for this component's properties
 	UMyComboAttackComponent();
 
+	/** Adds the combo montages, from the combo table when there is one */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	/** Triggered by gamepad button press */
-	void HandleAttackInput(AActor* Target = nullptr);
+	/**
+	 *  Triggered by gamepad button press.
+	 *  Starts a combo when idle, otherwise buffers the input until the combo window opens.
+	 *  @param Target - The attack target
+	 *  @param Input - The pressed input
+	 *  @return true if the input starts or can continue a combo
+	 */
+	bool HandleAttackInput(AActor* Target = nullptr, EComboInput Input = EComboInput::Light);
+
+	/**
+	 *  Triggered by gamepad button release, a held input continues the combo when the window opens.
+	 *  @param Input - The released input
+	 */
+	void ReleaseAttackInput(EComboInput Input = EComboInput::Light);
 
 	/** Reset combo state */
 	void ResetCombo();
@@ -32,28 +62,80 @@ public:
 	bool IsAttacking() const { return bIsAttacking; }
 
 private:
-	/** Play montage at current combo index */
-	void PlayComboMontage(int32 ComboIndex);
+	/** Play montage of the combo node and schedule its combo window */
+	void PlayComboNode(int32 NodeIndex);
+
+	/** Timer callback, continues the combo with the buffered input */
+	void OnComboWindowOpen();
+
+	/** Timer callback, later inputs no longer continue the combo */
+	void OnComboWindowClose();
+
+	/**
+	 *  Closes the combo window of the current attack and plays the next attack if an input continues the combo.
+	 *  @return true if the next attack started
+	 */
+	bool TryContinueCombo();
+
+	/**
+	 *  Finds the newest input pressed during the current attack that continues the combo.
+	 *  @return The next node, or INDEX_NONE
+	 */
+	int32 ResolveBufferedInput() const;
 
-	/** Montage notify callback */
-	UFUNCTION()
-	void OnMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& Payload);
+	/** Clears the combo window timers */
+	void ClearComboWindow();
+
+	/** Montage notify callback, routed only for attack hit notifies */
+	void OnMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& Payload, int32 AttackHitIndex);
 
 	/** Montage end callback */
 	void OnMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Resolve DefaultAttackHits and AttackHitTable into CompiledAttackHits */
+	void CompileAttackHits();
+
+	/** Resolve ComboTable, or ComboAttackMontages when there is no table, into ComboNodes */
+	void CompileComboGraph();
+
+	/** Maps a NextCombo key to its input, X and Light are light, Y and Heavy are heavy */
+	static EComboInput ParseComboInput(FName InputName);
+
 private:
 	UPROPERTY()
 	ACharacter* OwnerCharacter;
 
 	UPROPERTY()
-	UAnimInstance* AnimInstance;
+	TObjectPtr<UMyMontageDispatcherComponent> MontageDispatcher;
 
 	UPROPERTY()
 	AActor* CurrentAttackTarget;
 
+	/** Linear light combo, used when there is no combo table */
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation")
-	TArray<UAnimMontage*> ComboAttackMontages;
+	TArray<TSoftObjectPtr<UAnimMontage>> ComboAttackMontages;
+
+	/** Data table of FComboAttackData rows, compiled into the combo graph at BeginPlay */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation", meta = (RequiredAssetDataTags = "RowStructure=/Script/Raider.ComboAttackData"))
+	UDataTable* ComboTable;
+
+	/** How long before the combo window opens an input is still accepted */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config", meta = (ClampMin = "0.0"))
+	float InputBufferTime = 0.4f;
+
+	/** Attack hits available without a data table */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Hit")
+	TArray<FAttackHitData> DefaultAttackHits;
+
+	/** Data table of FAttackHitData rows, overrides default attack hits with the same notify name */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Hit", meta = (RequiredAssetDataTags = "RowStructure=/Script/Raider.AttackHitData"))
+	UDataTable* AttackHitTable;
+
+	/** Attack hits resolved at BeginPlay */
+	TArray<FCompiledAttackHit> CompiledAttackHits;
+
+	/** Index into CompiledAttackHits for each notify name, used to subscribe the notify routes */
+	TMap<FName, int32> AttackHitIndexByNotify;
 
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config")
 	float PlayerMontagePlayRate = 1.3f;
@@ -61,17 +143,52 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config")
 	float NPCMontagePlayRate = 1.0f;
 
-	UPROPERTY()
-	int32 CurrentComboIndex;
+	/** Combo graph resolved at BeginPlay */
+	TArray<FCompiledComboNode> ComboNodes;
 
+	/** Montages of the combo nodes, referenced here so the garbage collector keeps them loaded */
 	UPROPERTY()
-	bool bIsAttacking;
+	TArray<TObjectPtr<UAnimMontage>> ResolvedMontages;
 
-	UPROPERTY()
-	bool bIsNotifyBound;
+	/** Node starting a combo for each input */
+	int32 StartNodes[static_cast<uint8>(EComboInput::Count)];
+
+	/** Ring buffer of the latest inputs */
+	TStaticArray<FComboInputEvent, 8> InputBuffer;
+
+	/** Slot the next input is written to */
+	int32 InputBufferHead;
+
+	/** Input currently held down */
+	EComboInput HeldInput;
+
+	/** Node of the attack currently playing */
+	int32 CurrentNodeIndex;
+
+	/** Platform time the current attack started */
+	double CurrentNodeStartTime;
+
+	/** Platform time the combo window of the current attack opens */
+	double ComboWindowOpenTime;
+
+	/** Seconds the combo window of the current attack stays open */
+	float ComboWindowLength;
+
+	/** Whether inputs continue the combo right away */
+	bool bIsComboWindowOpen;
+
+	/** Whether the combo window of the current attack has already passed */
+	bool bIsComboWindowResolved;
+
+	/** Montages replaced by the next attack whose interrupted end event is still due */
+	int32 NumSupersededMontages;
+
+	FTimerHandle ComboWindowOpenTimer;
+
+	FTimerHandle ComboWindowCloseTimer;
 
 	UPROPERTY()
-	bool bComboHeld;
+	bool bIsAttacking;
 
 	UPROPERTY()
 	float DefaultWalkSpeed;
@@ -5,10 +5,12 @@
 #include "CoreMinimal.h"
 #include "CombatSystemAPI.h"
 #include "Components/ActorComponent.h"
+#include "Interfaces/MyPreloadInterface.h"
 #include "MyHealthComponent.generated.h"
 
 enum class EDamageReact : uint8;
 struct FSDamageInfo;
+class UMyMontageDispatcherComponent;
 
 /** Delegate to notify subscribers when character is dead */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDeath);
@@ -19,29 +21,47 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDeath);
  *  =====================================================
  */
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
-class COMBATSYSTEM_API UMyHealthComponent : public UActorComponent
+class COMBATSYSTEM_API UMyHealthComponent : public UActorComponent, public IMyPreloadInterface
 {
 	GENERATED_BODY()
 
 public:
 	UMyHealthComponent();
 
+	/** Adds the death montage */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
+	/** Health and MaxHealth replicate push based, only when the server changes them */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	/** Animation montage played when character is dead */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
-	TObjectPtr<UAnimMontage> DeathMontage;
+	TSoftObjectPtr<UAnimMontage> DeathMontage;
 	
-	/** Current health of the entity */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
+	/** Current health of the entity, changed at runtime through SetHealth */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_Health, Category = "Health")
 	float Health;
 
-	/** Maximum health of the entity */
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
+	/** Sets the health, marks it dirty for replication and flushes the net dormancy of the owner */
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void SetHealth(float NewHealth);
+
+	/** Maximum health of the entity, changed at runtime through SetMaxHealth */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Health")
 	float MaxHealth;
 
+	/**
+	 *  Sets the maximum health, marks it dirty for replication and flushes the net dormancy of the owner.
+	 *  @param NewMaxHealth - The new maximum health, the current health is clamped to it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void SetMaxHealth(float NewMaxHealth);
+
 	/**
 	 * Restores health to the entity.
 	 * @param HealAmount - The amount of health to restore.
@@ -63,6 +83,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Health")
 	bool IsAlive() const;
 
+	/** Restores full health and a fresh attack token pool, used when the owner is recycled after death */
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void ResetHealth();
+
 
 /**
  *  --------------------------------------------
@@ -70,16 +94,12 @@ public:
  *  --------------------------------------------
  */
 public:
-	/** The attack token available for the owning character to request */
+	/** The attack tokens the owning character hands out, registered with the attack token subsystem at BeginPlay */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health|Token")
 	int32 AttackTokenCount;
-
-	/** List of attackers who currently hold attack tokens */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Health|Token")
-	TArray<AActor*> Attackers;
 	
 	/**
-	 * Attempts to reserve attack tokens for an attacking entity.
+	 * Attempts to reserve attack tokens for an attacking entity, without waiting for them.
 	 * @param RequestingAttacker - The entity requesting attack permission.
 	 * @param Amount - The number of attack tokens to request.
 	 * @return True if tokens were successfully granted, false otherwise.
@@ -102,18 +122,27 @@ public:
  */	
 public:
 	/**
-	 *  Plays the death montage animation.
+	 *  Plays the death montage animation, skipped on a dedicated server.
 	 *  @param AnimMontage - The montage to play when character is dead
 	 */
 	UFUNCTION()
 	void PlayDeathMontage(UAnimMontage* AnimMontage) const;
 
 	/**
-	 *  Play ragboll death
+	 *  Play ragboll death, skipped on a dedicated server
 	 */
 	UFUNCTION()
 	void PlayDeathRagDoll() const;
 
+private:
+	/** Cached montage dispatcher of the owner */
+	UPROPERTY()
+	TObjectPtr<UMyMontageDispatcherComponent> MontageDispatcher;
+
+	/** Plays the death montage on clients, death itself is handled by the server */
+	UFUNCTION()
+	void OnRep_Health(float OldHealth);
+
 /**
  *  -----------------------------------------
  *  Delegate Events
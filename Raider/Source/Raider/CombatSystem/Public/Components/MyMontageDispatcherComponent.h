@@ -0,0 +1,205 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Animation/AnimInstance.h"
+#include "Components/ActorComponent.h"
+#include "MyMontageDispatcherComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+/** Native delegate receiving a routed montage notify */
+DECLARE_DELEGATE_TwoParams(FOnRoutedMontageNotify, FName /*NotifyName*/, const FBranchingPointNotifyPayload& /*Payload*/);
+
+/** End handler of one montage play */
+struct FPendingMontageEnd
+{
+	/** The played montage */
+	TObjectKey<UAnimMontage> Montage;
+
+	/** The caller's handler */
+	FOnMontageEnded Handler;
+};
+
+/** Notify dispatch counters, summed over all dispatchers */
+struct FMontageNotifyDispatchStats
+{
+	/** Notifies received from anim instances */
+	uint64 NumReceived = 0;
+
+	/** Handler invocations */
+	uint64 NumDispatched = 0;
+
+	/** Notifies without any subscribed handler */
+	uint64 NumUnrouted = 0;
+
+	/** Cycles spent routing and running handlers */
+	uint64 DispatchCycles = 0;
+};
+
+/**
+ *  =====================================================
+ *  Plays the combat montages of a character and routes their end and notify events.
+ *  The mesh and anim instance are cached once and refreshed when the mesh reinitializes
+ *  its animation, and the end and notify events are bound a single time. End handlers
+ *  are kept per montage instance, so each play reports to its own caller.
+ *  =====================================================
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class COMBATSYSTEM_API UMyMontageDispatcherComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMyMontageDispatcherComponent();
+
+	virtual void InitializeComponent() override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	/** Finds the dispatcher of an actor */
+	static UMyMontageDispatcherComponent* Get(const AActor* Actor);
+
+	/** The cached skeletal mesh of the owner */
+	USkeletalMeshComponent* GetMesh() const { return Mesh; }
+
+	/** The cached anim instance of the owner's mesh */
+	UAnimInstance* GetAnimInstance() const { return AnimInstance; }
+
+	/**
+	 *  Uses another skeletal mesh, rebinding the montage events to its anim instance.
+	 *  @param InMesh - The new mesh
+	 */
+	void SetMesh(USkeletalMeshComponent* InMesh);
+
+	/**
+	 *  Plays a montage on the cached anim instance.
+	 *  @param Montage - The montage to play
+	 *  @param PlayRate - The play rate
+	 *  @return Length of the montage, 0 if it could not be played
+	 */
+	float PlayMontage(UAnimMontage* Montage, float PlayRate = 1.0f) const;
+
+	/**
+	 *  Plays a montage and calls the handler when this play of it ends.
+	 *  @param Montage - The montage to play
+	 *  @param PlayRate - The play rate
+	 *  @param Handler - Object receiving the end event
+	 *  @param Func - Member function receiving the end event
+	 *  @return Length of the montage, 0 if it could not be played
+	 */
+	template <typename UserClass, typename FuncType>
+	float PlayMontage(UAnimMontage* Montage, const float PlayRate, UserClass* Handler, FuncType Func)
+	{
+		const float Length = PlayMontage(Montage, PlayRate);
+		if (Length > 0.0f)
+		{
+			AddMontageEndHandler(Montage, FOnMontageEnded::CreateUObject(Handler, Func));
+		}
+		return Length;
+	}
+
+	/**
+	 *  Stops the active montages.
+	 *  @param BlendOutTime - Blend out duration
+	 */
+	void StopMontages(float BlendOutTime) const;
+
+	/** Whether any montage is playing */
+	bool IsAnyMontagePlaying() const;
+
+	/**
+	 *  Subscribes a handler to a notify name. Only the handlers of a notify are invoked when it fires.
+	 *  @param NotifyName - The montage notify name
+	 *  @param Handler - The handler, bound once by the caller
+	 */
+	void AddNotifyHandler(FName NotifyName, FOnRoutedMontageNotify&& Handler);
+
+	/**
+	 *  Subscribes a handler to every notify of a montage.
+	 *  @param Montage - The montage whose notifies are routed to the handler
+	 *  @param Handler - The handler, bound once by the caller
+	 */
+	void AddMontageNotifyHandler(const UAnimMontage* Montage, FOnRoutedMontageNotify&& Handler);
+
+	/** Removes every notify handler bound to an object */
+	void RemoveNotifyHandlers(const UObject* HandlerObject);
+
+	/** Notify dispatch counters of all dispatchers */
+	static const FMontageNotifyDispatchStats& GetDispatchStats() { return DispatchStats; }
+
+	/** Clears the notify dispatch counters */
+	static void ResetDispatchStats() { DispatchStats = FMontageNotifyDispatchStats(); }
+
+private:
+	/** The owner's skeletal mesh */
+	UPROPERTY()
+	TObjectPtr<USkeletalMeshComponent> Mesh;
+
+	/** The anim instance the montage events are bound to */
+	UPROPERTY()
+	TObjectPtr<UAnimInstance> AnimInstance;
+
+	/** Handler list of a notify route, one handler per subscriber in practice */
+	using FNotifyHandlerList = TArray<FOnRoutedMontageNotify, TInlineAllocator<1>>;
+
+	/** Notify handlers keyed by notify name, FName keys hash by their comparison index */
+	TMap<FName, FNotifyHandlerList> NotifyHandlersByName;
+
+	/** Notify handlers keyed by montage */
+	TMap<TObjectKey<UAnimSequenceBase>, FNotifyHandlerList> NotifyHandlersByMontage;
+
+	/** End handlers keyed by the instance id of the play they wait for */
+	TMap<int32, FPendingMontageEnd> PendingMontageEnds;
+
+	/** Depth of running notify dispatches, handlers removed meanwhile are only unbound and added ones are deferred */
+	int32 NotifyDispatchDepth = 0;
+
+	/** Name handlers added during a dispatch, routed once it finishes */
+	TArray<TPair<FName, FOnRoutedMontageNotify>> DeferredNameHandlers;
+
+	/** Montage handlers added during a dispatch, routed once it finishes */
+	TArray<TPair<TObjectKey<UAnimSequenceBase>, FOnRoutedMontageNotify>> DeferredMontageHandlers;
+
+	/** Whether handlers were unbound during a dispatch and wait for compaction */
+	bool bHasUnboundNotifyHandlers = false;
+
+	/** Counters shared by all dispatchers */
+	static FMontageNotifyDispatchStats DispatchStats;
+
+	/** Binds the montage events of the mesh's current anim instance */
+	void BindAnimInstance();
+
+	/** Unbinds the montage events of the cached anim instance */
+	void UnbindAnimInstance();
+
+	/** Keys an end handler by the instance of the montage that was just played */
+	void AddMontageEndHandler(UAnimMontage* Montage, FOnMontageEnded&& Handler);
+
+	/** Removes unbound notify handlers and empty routes */
+	void CompactNotifyHandlers();
+
+	/** Compacts the handlers removed and routes the handlers added while notifies were dispatched */
+	void FinishNotifyDispatch();
+
+	/** Called when the mesh initializes a new anim instance */
+	UFUNCTION()
+	void OnMeshAnimInitialized();
+
+	/**
+	 *  Routes the end of a montage play to the handler of its instance.
+	 *  The ended instance is already removed from the anim instance, so it is the one whose id no longer resolves.
+	 *  @param Montage - The montage that ended
+	 *  @param bInterrupted - Whether the play was interrupted
+	 */
+	UFUNCTION()
+	void OnMontageEnded(UAnimMontage* Montage, bool bInterrupted);
+
+	/** Routes a montage notify to the handlers of its name and montage */
+	UFUNCTION()
+	void OnMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload);
+};
@@ -5,13 +5,16 @@
 #include "CoreMinimal.h"
 #include "CombatSystemAPI.h"
 #include "Components/ActorComponent.h"
+#include "Interfaces/MyPreloadInterface.h"
 #include "MySpinAttackComponent.generated.h"
 
 
+struct FSDamageInfo;
 class ARaiderCharacter;
+class UMyMontageDispatcherComponent;
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
-class COMBATSYSTEM_API UMySpinAttackComponent : public UActorComponent
+class COMBATSYSTEM_API UMySpinAttackComponent : public UActorComponent, public IMyPreloadInterface
 {
 	GENERATED_BODY()
 
@@ -19,22 +22,57 @@ public:
 	// Sets default values for this component's properties
 	UMySpinAttackComponent();
 
+	/** Adds the spin montage */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
+	// Advances the spin, only enabled while spinning
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
 	/** Startup animation */
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation")
-	UAnimMontage* SpinMontage;
+	TSoftObjectPtr<UAnimMontage> SpinMontage;
 
 	/** Spin rotation speed in degrees/second */
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config")
 	float SpinRotationSpeed = 720.0f;
 
+	/** Montage section where the spin loop starts, the rotation begins at its start time */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation")
+	FName SpinLoopSectionName;
+
+	/** Loop start time used when the montage has no loop section, as the shipped Greystone spin montage does */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation")
+	float DefaultSpinLoopStartTime;
+
+	/** Optional montage curve scaling the rotation speed, the speed is constant when the curve is missing */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Animation")
+	FName SpinSpeedCurveName;
+
 	/** Max time allowed for spinning in second */
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config")
 	float MaxSpinDuration = 5.0f;
+
+	/** Radius around the character hit by the spin */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Damage")
+	float SpinRadius;
+
+	/** Damage dealt by each spin hit */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Damage")
+	float SpinDamage;
+
+	/** Damage every frame of the spin instead of only when the Spin notify fires, off keeps the one hit per notify */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Damage")
+	bool bContinuousDamage;
+
+	/** Seconds before the same target can be hit again by a continuous spin */
+	UPROPERTY(EditDefaultsOnly, Category = "Attack|Damage", meta = (EditCondition = "bContinuousDamage", ClampMin = "0.0"))
+	float ReHitInterval;
 	
 	/** Call when spin input is pressed */
 	UFUNCTION(BlueprintCallable, Category = "Attack")
@@ -52,18 +90,28 @@ private:
 	UPROPERTY()
 	ARaiderCharacter* OwnerCharacter;
 
-	/** Handle for spin rotation updates */
-	FTimerHandle SpinLoopTimer;
-
-	/** Delay before loop starts */
-	FTimerHandle SpinTransitionTimer;
-
-	/** Spin duration timer */
-	FTimerHandle SpinDurationTimer;
+	/** Cached montage dispatcher of the owner */
+	UPROPERTY()
+	TObjectPtr<UMyMontageDispatcherComponent> MontageDispatcher;
 
 	/** Whether the spin is active */
 	bool bIsSpinning;
 
+	/** Time since the spin started */
+	float SpinElapsedTime;
+
+	/** Time after the spin start at which the rotation begins, resolved from the montage once it is preloaded */
+	float SpinLoopStartTime;
+
+	/** Character location at the last continuous damage query */
+	FVector LastSpinLocation;
+
+	/** World time at which each target can be hit again by the current spin */
+	TMap<TObjectKey<AActor>, double> NextHitTimes;
+
+	/** Scratch buffer of actors found by a continuous damage query */
+	TArray<AActor*> ScratchHitActors;
+
 	/** Walk speed the system set */
 	float DefaultWalkSpeed;
 
@@ -71,13 +119,24 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = "Attack|Config")
 	float AttackWalkSpeed;
 	
-	/** Called after SpinStart montage finishes */
-	void EnterSpinLoop();
+	/** Resolves the loop start time once the owner's assets are preloaded */
+	void OnSpinMontagePreloaded(double LoadSeconds);
+
+	/** Finds the loop start time from the montage sections, the default when it has no loop section */
+	float ResolveSpinLoopStartTime(const UAnimMontage& Montage) const;
+
+	/**
+	 *  Rotates the mesh during spin loop.
+	 *  @param SpinTime - Time spent in the loop this frame
+	 */
+	void UpdateSpin(float SpinTime);
+
+	/** Damages the targets swept by the character since the last frame which are off their re-hit cooldown */
+	void UpdateSpinDamage();
 
-	/** Rotates the mesh during spin loop */
-	void UpdateSpin();
+	/** Builds the damage of a spin hit */
+	FSDamageInfo MakeSpinDamageInfo() const;
 
-	/** Called when an animation notify begins during the spin attack montage */
-	UFUNCTION()
+	/** Called when the Spin notify begins during the spin attack montage */
 	void OnAttackMontageNotifyBegin(FName NotifyName, const FBranchingPointNotifyPayload& BranchingPointPayload);
 };
@@ -0,0 +1,17 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Enum for Combo Input
+ */
+UENUM(BlueprintType)
+enum class EComboInput : uint8
+{
+	None			UMETA(DisplayName = "None"),
+	Light			UMETA(DisplayName = "Light"),
+	Heavy			UMETA(DisplayName = "Heavy"),
+	Count			UMETA(Hidden)
+};
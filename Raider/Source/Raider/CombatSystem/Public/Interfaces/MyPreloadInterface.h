@@ -0,0 +1,79 @@
+// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "CombatSystemAPI.h"
+#include "MyPreloadInterface.generated.h"
+
+// Native only, the assets are gathered from class default objects
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class UMyPreloadInterface : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ *	=========================================================================
+ *  Implemented by actors and components holding soft references to the assets they play
+ *  or spawn, so the asset preload subsystem can stream them in before the actor is spawned
+ *  =========================================================================
+ */
+class COMBATSYSTEM_API IMyPreloadInterface
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 *  Adds the soft referenced assets needed once the actor is spawned. Called on class default objects.
+	 *  @param OutAssets - Receives the asset paths
+	 */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const = 0;
+
+	/** Adds a soft reference to the gathered assets unless it is empty */
+	template <typename SoftPtrType>
+	static void AddPreloadAsset(TArray<FSoftObjectPath>& OutAssets, const SoftPtrType& Asset)
+	{
+		if (!Asset.IsNull())
+		{
+			OutAssets.Add(Asset.ToSoftObjectPath());
+		}
+	}
+
+	/** Returns the asset of a soft reference, loading it synchronously with a log when it was not preloaded */
+	template <typename T>
+	static T* ResolveAsset(const TSoftObjectPtr<T>& Asset)
+	{
+		if (T* LoadedAsset = Asset.Get())
+		{
+			return LoadedAsset;
+		}
+
+		if (Asset.IsNull())
+		{
+			return nullptr;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("%s was not preloaded and is loaded synchronously"), *Asset.ToString());
+		return Asset.LoadSynchronous();
+	}
+
+	/** Returns the class of a soft reference, loading it synchronously with a log when it was not preloaded */
+	template <typename T>
+	static TSubclassOf<T> ResolveClass(const TSoftClassPtr<T>& Class)
+	{
+		if (UClass* LoadedClass = Class.Get())
+		{
+			return LoadedClass;
+		}
+
+		if (Class.IsNull())
+		{
+			return nullptr;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("%s was not preloaded and is loaded synchronously"), *Class.ToString());
+		return Class.LoadSynchronous();
+	}
+};
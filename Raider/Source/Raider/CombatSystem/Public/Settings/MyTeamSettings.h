@@ -0,0 +1,38 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Engine/DeveloperSettings.h"
+#include "Structs/FTeamAttitudeRule.h"
+#include "MyTeamSettings.generated.h"
+
+/**
+ *  =====================================================
+ *  Project settings describing how teams see each other.
+ *  Read once per world by the team registry to build its attitude matrix.
+ *  =====================================================
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Teams"))
+class COMBATSYSTEM_API UMyTeamSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UMyTeamSettings();
+
+	virtual FName GetCategoryName() const override;
+
+	/** Attitude between two different teams unless a rule says otherwise */
+	UPROPERTY(Config, EditAnywhere, Category = "Teams")
+	TEnumAsByte<ETeamAttitude::Type> DefaultAttitude;
+
+	/** Attitude of a team towards its own members */
+	UPROPERTY(Config, EditAnywhere, Category = "Teams")
+	TEnumAsByte<ETeamAttitude::Type> SameTeamAttitude;
+
+	/** Pairs of teams which deviate from the default attitude, e.g. factions allied with the player team 255 */
+	UPROPERTY(Config, EditAnywhere, Category = "Teams")
+	TArray<FTeamAttitudeRule> AttitudeRules;
+};
@@ -0,0 +1,42 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataTable.h"
+#include "Structs/FSDamageInfo.h"
+#include "FAttackHitData.generated.h"
+
+/** Struct to store the hit shape and damage of an attack, keyed by the montage notify that triggers it */
+USTRUCT(BlueprintType)
+struct FAttackHitData : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	/** The montage notify that triggers the hit, the row name is used when left empty */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName NotifyName;
+
+	/** How far the hit sphere is swept along the character's forward vector */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float Reach = 50.0f;
+
+	/** Radius of the hit sphere */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float Radius = 150.0f;
+
+	/** Damage applied to every hit non team member */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FSDamageInfo DamageInfo = FSDamageInfo(10.0f, EDamageType::Melee, EDamageReact::Hit, false, false, false);
+};
+
+/** Attack hit resolved from FAttackHitData, laid out flat for the notify dispatch */
+struct FCompiledAttackHit
+{
+	/** How far the hit sphere is swept along the character's forward vector */
+	float Reach;
+
+	/** Radius of the hit sphere */
+	float Radius;
+
+	/** Damage applied to every hit non team member */
+	FSDamageInfo DamageInfo;
+};
@@ -3,6 +3,7 @@
 #include "CoreMinimal.h"
 #include "Engine/DataTable.h"
 #include "Animation/AnimMontage.h"
+#include "Enums/EComboInput.h"
 #include "FComboAttackData.generated.h"
 
 /** Struct to store each combo attack data */
@@ -11,9 +12,9 @@ struct FComboAttackData : public FTableRowBase
 {
 	GENERATED_BODY()
 
-	/** The attack montage to play */
+	/** The attack montage to play, preloaded with the owning character */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UAnimMontage* AttackMontage;
+	TSoftObjectPtr<UAnimMontage> AttackMontage;
 
 	/** The valid follow-up attacks (X or Y) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -24,5 +25,25 @@ struct FComboAttackData : public FTableRowBase
 	float ComboWindowOpenTime = 0.6f;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0", ClampMax = "1.0"))
-	float ComboWindowCloseTime = 0.95f;	
+	float ComboWindowCloseTime = 0.95f;
+
+	/** The input starting a combo with this attack, None for follow-up only attacks */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EComboInput StartInput = EComboInput::None;
+};
+
+/** Combo attack resolved from FComboAttackData, transitions are node indices per input */
+struct FCompiledComboNode
+{
+	/** The attack montage to play, kept alive by the owning component */
+	UAnimMontage* AttackMontage = nullptr;
+
+	/** Node played for each input inside the combo window, INDEX_NONE when the input ends the combo */
+	int32 NextNodes[static_cast<uint8>(EComboInput::Count)] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+
+	/** Montage fraction at which the combo window opens */
+	float ComboWindowOpenTime = 0.6f;
+
+	/** Montage fraction at which the combo window closes */
+	float ComboWindowCloseTime = 0.95f;
 };
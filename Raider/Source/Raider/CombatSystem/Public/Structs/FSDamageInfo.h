@@ -53,4 +53,19 @@ public:
 
 	/** Converts struct data to a string (for debugging) */
 	FString ToString() const;
+
+	/**
+	 *  Bit-packs the damage for replication. The amount is quantized to 0.1 and written as a packed
+	 *  integer, the damage type, the reaction and the three flags share a single byte.
+	 */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSDamageInfo> : public TStructOpsTypeTraitsBase2<FSDamageInfo>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
 };
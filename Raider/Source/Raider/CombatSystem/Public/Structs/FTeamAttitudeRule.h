@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericTeamAgentInterface.h"
+#include "FTeamAttitudeRule.generated.h"
+
+/** Struct to store how two teams see each other, applied symmetrically to the team attitude matrix */
+USTRUCT(BlueprintType)
+struct FTeamAttitudeRule
+{
+	GENERATED_BODY()
+
+	/** First team number */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	uint8 TeamA = 0;
+
+	/** Second team number */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	uint8 TeamB = 0;
+
+	/** Attitude between the two teams */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TEnumAsByte<ETeamAttitude::Type> Attitude = ETeamAttitude::Friendly;
+};
@@ -0,0 +1,93 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyAssetPreloadSubsystem.generated.h"
+
+/** Delegate to notify the caller when every asset of a preload is loaded, with the time it took */
+DECLARE_DELEGATE_OneParam(FOnAssetPreloadComplete, double /* LoadSeconds */);
+
+/** A preload waiting for its assets */
+struct FAssetPreload
+{
+	/** Called once every pass finished */
+	FOnAssetPreloadComplete OnComplete;
+
+	/** Platform time the preload started at */
+	double StartTime = 0.0;
+
+	/** Classes the preload was started with */
+	int32 NumClasses = 0;
+
+	/** Classes and assets of the preload, every one is loaded once by the preload */
+	TSet<FSoftObjectPath> Assets;
+
+	/** Assets no earlier preload requested */
+	int32 NumNewAssets = 0;
+
+	/** Load passes, each pass loads the assets referenced by the previous one */
+	int32 NumPasses = 0;
+};
+
+/**
+ *  =====================================================
+ *  Streams enemy classes and the soft referenced assets they play or spawn before a wave needs
+ *  them, so spawning doesn't hitch on synchronous loads. Loaded classes are scanned for actors
+ *  and components implementing IMyPreloadInterface, the assets they add are loaded in the next
+ *  pass until nothing new is found. Loaded assets stay referenced for the lifetime of the world.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyAssetPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 *  Loads classes asynchronously together with the assets their defaults reference.
+	 *  @param Classes - The classes to load, null entries are skipped
+	 *  @param OnComplete - Called once everything is loaded, right away when it already is
+	 *  @return Id of the preload, used in the log
+	 */
+	int32 PreloadClasses(TConstArrayView<TSoftClassPtr<AActor>> Classes, FOnAssetPreloadComplete OnComplete);
+
+	/** Number of preloads still loading */
+	int32 GetNumPendingPreloads() const { return Preloads.Num(); }
+
+private:
+	/** Streams the requested assets, owned by the world so its handles go away with it */
+	FStreamableManager StreamableManager;
+
+	/** Handles keeping the loaded assets referenced */
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+
+	/** Every asset requested so far, each is only requested once */
+	TSet<FSoftObjectPath> RequestedAssets;
+
+	/** Assets referenced by each loaded class, scanned once and shared by every preload */
+	TMap<FSoftObjectPath, TArray<FSoftObjectPath>> ReferencedAssets;
+
+	/** Preloads still loading */
+	TMap<int32, FAssetPreload> Preloads;
+
+	/** Id handed to the next preload */
+	int32 NextPreloadId = 0;
+
+	/** Requests one load pass, finishes the preload when there is nothing left to load */
+	void RequestPass(int32 PreloadId, TArray<FSoftObjectPath>&& Assets);
+
+	/** Gathers the assets referenced by the loaded assets of a pass and requests the next pass */
+	void OnPassLoaded(int32 PreloadId, TArray<FSoftObjectPath> Assets);
+
+	/** Adds the assets referenced by a loaded class, through its defaults and their subobjects */
+	void GatherClassAssets(UClass* Class, TArray<FSoftObjectPath>& OutAssets) const;
+
+	/** Logs the preload and calls its completion delegate */
+	void FinishPreload(int32 PreloadId);
+};
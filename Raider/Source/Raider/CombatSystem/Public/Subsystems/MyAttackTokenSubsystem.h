@@ -0,0 +1,182 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyAttackTokenSubsystem.generated.h"
+
+/** Called when a queued attack token request is granted, or dropped because the target went away */
+DECLARE_DELEGATE_OneParam(FOnAttackTokenResolved, bool /* bGranted */);
+
+/** Outcome of an attack token request */
+enum class EAttackTokenRequestResult : uint8
+{
+	/** The attacker holds the token */
+	Granted,
+
+	/** The attacker waits in the queue of the target and is notified when granted */
+	Queued,
+
+	/** The request was invalid */
+	Denied
+};
+
+/** Attack tokens held by an attacker until returned or expired */
+struct FAttackTokenLease
+{
+	/** The attacker holding the tokens */
+	TWeakObjectPtr<AActor> Attacker;
+
+	/** Number of tokens held */
+	int32 Amount = 0;
+
+	/** World time at which the tokens return on their own */
+	double ExpireTime = 0.0;
+};
+
+/** An attacker waiting for tokens */
+struct FAttackTokenWaiter
+{
+	/** The waiting attacker */
+	TWeakObjectPtr<AActor> Attacker;
+
+	/** Number of tokens requested */
+	int32 Amount = 0;
+
+	/** Higher priorities are served first, equal priorities in request order */
+	int32 Priority = 0;
+
+	/** Notified when the request is resolved */
+	FOnAttackTokenResolved OnResolved;
+};
+
+/** The attack tokens of a target */
+struct FAttackTokenPool
+{
+	/** Number of tokens the target hands out */
+	int32 Capacity = 0;
+
+	/** Number of tokens not leased */
+	int32 Available = 0;
+
+	/** Tokens currently held by attackers */
+	TArray<FAttackTokenLease, TInlineAllocator<4>> Leases;
+
+	/** Attackers waiting for tokens, in service order */
+	TArray<FAttackTokenWaiter> Waiters;
+};
+
+/**
+ *  =====================================================
+ *  Hands out the attack tokens of every target, so only a few attackers engage at once.
+ *  Attackers that can't get a token wait in a per-target queue and are notified when
+ *  granted instead of polling. Tokens are leased and return on their own when the lease
+ *  expires or the attacker is gone, so they can't leak.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyAttackTokenSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+/**
+ *	---------------------------------------------
+ *  Targets
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Starts handing out the attack tokens of a target, or changes its token count.
+	 *  @param Target - The attacked actor
+	 *  @param Capacity - Number of tokens the target hands out
+	 */
+	void RegisterTarget(AActor* Target, int32 Capacity);
+
+	/**
+	 *  Stops handing out the attack tokens of a target, waiting attackers are notified with a failure.
+	 *  @param Target - The attacked actor
+	 */
+	void UnregisterTarget(const AActor* Target);
+
+/**
+ *	---------------------------------------------
+ *  Attackers
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Requests tokens without waiting. Attackers holding tokens renew their lease.
+	 *  Targets without registered tokens can be attacked by everyone.
+	 *  @param Target - The attacked actor
+	 *  @param Attacker - The attacker requesting the tokens
+	 *  @param Amount - Number of tokens requested
+	 *  @return true if the attacker holds the tokens
+	 */
+	bool RequestToken(const AActor* Target, AActor* Attacker, int32 Amount);
+
+	/**
+	 *  Requests tokens, queueing the attacker when none are available.
+	 *  @param Target - The attacked actor
+	 *  @param Attacker - The attacker requesting the tokens
+	 *  @param Amount - Number of tokens requested
+	 *  @param Priority - Position in the queue, higher priorities are served first
+	 *  @param OnResolved - Called once when a queued request is granted or dropped, never for an immediate result
+	 *  @return Whether the tokens were granted, queued or denied
+	 */
+	EAttackTokenRequestResult RequestTokenOrWait(const AActor* Target, AActor* Attacker, int32 Amount, int32 Priority, FOnAttackTokenResolved&& OnResolved);
+
+	/**
+	 *  Returns the tokens held by an attacker and hands them to the next waiting attackers.
+	 *  @param Target - The attacked actor
+	 *  @param Attacker - The attacker returning its tokens
+	 */
+	void ReturnToken(const AActor* Target, const AActor* Attacker);
+
+	/**
+	 *  Removes an attacker from the queue of a target without notifying it.
+	 *  @param Target - The attacked actor
+	 *  @param Attacker - The waiting attacker
+	 */
+	void CancelWait(const AActor* Target, const AActor* Attacker);
+
+	/**
+	 *  Returns all tokens of an attacker and removes it from every queue, used when it dies or leaves the world.
+	 *  @param Attacker - The attacker
+	 */
+	void ReleaseAttacker(const AActor* Attacker);
+
+	/** Whether the attacker holds tokens of the target */
+	bool HasToken(const AActor* Target, const AActor* Attacker) const;
+
+private:
+	/** Token pools per target */
+	TMap<TObjectKey<AActor>, FAttackTokenPool> Pools;
+
+	/** Earliest lease expiry, the leases are only checked once it passed */
+	double NextExpireTime = TNumericLimits<double>::Max();
+
+	/** Callbacks of granted requests, run once the pools are consistent */
+	using FResolvedCallbacks = TArray<FOnAttackTokenResolved, TInlineAllocator<4>>;
+
+	/** Leases tokens of the pool to an attacker */
+	void GrantLease(FAttackTokenPool& Pool, AActor* Attacker, int32 Amount);
+
+	/** Returns the tokens of an attacker to the pool, returns true if it held any */
+	static bool RemoveLease(FAttackTokenPool& Pool, const AActor* Attacker);
+
+	/** Removes an attacker from the queue of the pool */
+	static void RemoveWaiter(FAttackTokenPool& Pool, const AActor* Attacker);
+
+	/** Grants the available tokens to the waiters in queue order */
+	void GrantWaiters(FAttackTokenPool& Pool, FResolvedCallbacks& OutGranted);
+
+	/** Runs the callbacks, which may request or return tokens again */
+	static void NotifyResolved(FResolvedCallbacks& Callbacks, bool bGranted);
+};
@@ -0,0 +1,129 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Structs/FSDamageInfo.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyCombatQuerySubsystem.generated.h"
+
+class UMyCombatComponent;
+class UMyCombatantGridSubsystem;
+
+/**
+ *  A melee hit request issued by an attack notify.
+ *  The shape is a sphere swept from Start to End, which is queried as a single capsule overlap.
+ */
+struct FCombatHitRequest
+{
+	/** Combat component that owns the attack and applies the damage */
+	TWeakObjectPtr<UMyCombatComponent> Instigator;
+
+	/** Start of the swept sphere */
+	FVector Start = FVector::ZeroVector;
+
+	/** End of the swept sphere */
+	FVector End = FVector::ZeroVector;
+
+	/** Radius of the swept sphere */
+	float Radius = 0.0f;
+
+	/** Damage applied to every non team member inside the shape */
+	FSDamageInfo DamageInfo;
+};
+
+/**
+ *  =====================================================
+ *  Collects the melee hit requests issued during a frame and resolves them as one batch.
+ *  The batch is answered by the combatant grid at the end of the frame, or by async overlap
+ *  queries resolved when the world processes async traces at the start of the next frame.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyCombatQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 *  Queues a swept sphere hit query for the current frame.
+	 *  Requests issued by the local player are resolved immediately when Raider.Combat.ImmediateLocalPlayerHits is set.
+	 *  @param Instigator - The combat component of the attacker
+	 *  @param Start - Start of the swept sphere
+	 *  @param End - End of the swept sphere
+	 *  @param Radius - Radius of the swept sphere
+	 *  @param DamageInfo - The damage applied to every hit non team member
+	 */
+	void QueueHitQuery(UMyCombatComponent* Instigator, const FVector& Start, const FVector& End, float Radius, const FSDamageInfo& DamageInfo);
+
+	/**
+	 *  Finds the actors touching a swept sphere right away, against the combatant grid or as a blocking overlap.
+	 *  Used by attacks that filter the targets themselves before applying damage.
+	 *  @param Instigator - The combat component of the attacker, its owner is excluded
+	 *  @param Start - Start of the swept sphere
+	 *  @param End - End of the swept sphere
+	 *  @param Radius - Radius of the swept sphere
+	 *  @param OutActors - Receives the found actors, team members are only filtered by the grid
+	 *  @return Number of actors added to OutActors
+	 */
+	int32 QueryHitActors(const UMyCombatComponent* Instigator, const FVector& Start, const FVector& End, float Radius, TArray<AActor*>& OutActors);
+
+private:
+	/** Requests queued during the current frame */
+	TArray<FCombatHitRequest> PendingRequests;
+
+	/** Requests submitted last frame, indexed by the async trace user data */
+	TArray<FCombatHitRequest> InFlightRequests;
+
+	/** Delegate invoked by the world for every completed async overlap */
+	FOverlapDelegate OverlapDelegate;
+
+	/** Scratch buffer used by immediate overlaps */
+	TArray<FOverlapResult> ScratchOverlaps;
+
+	/** Scratch buffer of actors found by a request */
+	TArray<AActor*> ScratchActors;
+
+	/** Scratch buffer of combat components found by a grid request */
+	TArray<UMyCombatComponent*> ScratchCombatComponents;
+
+	/** Combatant grid of the world */
+	UPROPERTY()
+	TObjectPtr<UMyCombatantGridSubsystem> CombatantGrid;
+
+	/** Whether requests are answered by the combatant grid instead of the physics scene */
+	bool ShouldUseCombatantGrid() const;
+
+	/** Resolves all pending requests against the combatant grid */
+	void ResolvePendingRequestsFromGrid();
+
+	/** Resolves the request against the combatant grid and applies its damage */
+	void ApplyGridHits(const FCombatHitRequest& Request);
+
+	/** Submits all pending requests as async overlaps */
+	void SubmitPendingRequests();
+
+	/** Resolves the request right away, against the combatant grid or as a blocking overlap */
+	void ResolveImmediately(const FCombatHitRequest& Request);
+
+	/** Async overlap completion callback */
+	void OnOverlapCompleted(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum);
+
+	/** Applies the request damage to the overlapped actors */
+	void ApplyOverlaps(const FCombatHitRequest& Request, const TArray<FOverlapResult>& Overlaps);
+
+	/** Applies the request damage to the actors in ScratchActors */
+	void ApplyScratchActors(const FCombatHitRequest& Request);
+
+	/** Whether the request was issued by a locally controlled player */
+	static bool IsLocalPlayerRequest(const FCombatHitRequest& Request);
+
+	/** Builds the capsule covering a sphere swept from Start to End */
+	static FCollisionShape MakeSweptSphereShape(const FCombatHitRequest& Request, FVector& OutCenter, FQuat& OutRotation);
+};
@@ -0,0 +1,176 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyCombatantGridSubsystem.generated.h"
+
+class UCapsuleComponent;
+class UMyCombatComponent;
+class UMyTeamRegistrySubsystem;
+
+/** A combatant capsule tracked by the grid */
+struct FCombatantGridEntry
+{
+	/** The combatant actor */
+	TWeakObjectPtr<AActor> Actor;
+
+	/** Combat component of the combatant, handed to the damage path so it is not searched per hit */
+	TWeakObjectPtr<UMyCombatComponent> CombatComponent;
+
+	/** The capsule representing the combatant */
+	TWeakObjectPtr<UCapsuleComponent> Capsule;
+
+	/** Capsule center at the last transform update */
+	FVector Location = FVector::ZeroVector;
+
+	/** Capsule radius */
+	float Radius = 0.0f;
+
+	/** Capsule half height, including the hemispheres */
+	float HalfHeight = 0.0f;
+
+	/** Team id of the combatant in the team registry */
+	uint8 TeamId = 0;
+
+	/** Grid cell the combatant is stored in */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+
+	/** Handle of the capsule transform binding */
+	FDelegateHandle TransformUpdatedHandle;
+};
+
+/**
+ *  =====================================================
+ *  Uniform 2D grid of live combatant capsules, updated incrementally when they move.
+ *  Answers sphere, capsule and arc queries that only return hostile combatants, so melee
+ *  attacks only visit a handful of cells instead of querying the physics scene.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyCombatantGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+/**
+ *	---------------------------------------------
+ *  Registration
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Starts tracking the owner of a combat component, with the team id the component registered.
+	 *  @param CombatComponent - Combat component of the actor to track, the owner's root capsule is used as shape
+	 */
+	void RegisterCombatant(UMyCombatComponent* CombatComponent);
+
+	/**
+	 *  Stops tracking a combatant.
+	 *  @param Combatant - The actor to remove
+	 */
+	void UnregisterCombatant(const AActor* Combatant);
+
+	/** Number of combatants currently tracked */
+	int32 GetNumCombatants() const { return Combatants.Num(); }
+
+/**
+ *	---------------------------------------------
+ *  Queries
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Finds the combatants touching a sphere which are hostile to the instigator.
+	 *  @param Center - Sphere center
+	 *  @param Radius - Sphere radius
+	 *  @param Instigator - The querying actor, excluded together with non hostile combatants
+	 *  @param OutActors - Receives the found combatants
+	 *  @return Number of combatants added to OutActors
+	 */
+	int32 QuerySphere(const FVector& Center, float Radius, const AActor* Instigator, TArray<AActor*>& OutActors) const;
+
+	/**
+	 *  Finds the combatants touching a sphere swept from Start to End which are hostile to the instigator.
+	 *  @param Start - Start of the swept sphere
+	 *  @param End - End of the swept sphere
+	 *  @param Radius - Sphere radius
+	 *  @param Instigator - The querying actor, excluded together with non hostile combatants
+	 *  @param OutActors - Receives the found combatants
+	 *  @return Number of combatants added to OutActors
+	 */
+	int32 QueryCapsule(const FVector& Start, const FVector& End, float Radius, const AActor* Instigator, TArray<AActor*>& OutActors) const;
+
+	/**
+	 *  Finds the combat components of the combatants touching a swept sphere which are hostile to the instigator.
+	 *  @param Start - Start of the swept sphere
+	 *  @param End - End of the swept sphere
+	 *  @param Radius - Sphere radius
+	 *  @param Instigator - The querying actor, excluded together with non hostile combatants
+	 *  @param OutCombatComponents - Receives the combat components of the found combatants
+	 *  @return Number of combat components added to OutCombatComponents
+	 */
+	int32 QueryCapsule(const FVector& Start, const FVector& End, float Radius, const AActor* Instigator, TArray<UMyCombatComponent*>& OutCombatComponents) const;
+
+	/**
+	 *  Finds the combatants inside a horizontal arc which are hostile to the instigator.
+	 *  @param Origin - Arc origin
+	 *  @param Direction - Arc center direction
+	 *  @param Radius - Arc radius
+	 *  @param HalfAngleDegrees - Half of the arc opening angle
+	 *  @param Instigator - The querying actor, excluded together with non hostile combatants
+	 *  @param OutActors - Receives the found combatants
+	 *  @return Number of combatants added to OutActors
+	 */
+	int32 QueryArc(const FVector& Origin, const FVector& Direction, float Radius, float HalfAngleDegrees, const AActor* Instigator, TArray<AActor*>& OutActors) const;
+
+	/** Blueprint access to QuerySphere for AOE attacks */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Query", meta = (DisplayName = "Query Combatants In Sphere"))
+	TArray<AActor*> K2_QuerySphere(const FVector& Center, float Radius, const AActor* Instigator) const;
+
+	/** Blueprint access to QueryArc for AOE attacks */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Query", meta = (DisplayName = "Query Combatants In Arc"))
+	TArray<AActor*> K2_QueryArc(const FVector& Origin, const FVector& Direction, float Radius, float HalfAngleDegrees, const AActor* Instigator) const;
+
+private:
+	/** Team registry providing the attitude between combatants */
+	UPROPERTY()
+	TObjectPtr<UMyTeamRegistrySubsystem> TeamRegistry;
+
+	/** Tracked combatants */
+	TSparseArray<FCombatantGridEntry> Combatants;
+
+	/** Combatant indices per grid cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** Combatant index per actor */
+	TMap<TObjectKey<AActor>, int32> CombatantIndices;
+
+	/** Edge length of a grid cell */
+	float CellSize = 500.0f;
+
+	/** Largest registered capsule radius, used to widen query bounds */
+	float MaxCombatantRadius = 0.0f;
+
+	/** Called when a tracked capsule moves */
+	void OnCombatantMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport, int32 CombatantIndex);
+
+	/** Converts a world location to its grid cell */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Builds the 2D bounds of a sphere swept from Start to End */
+	static FBox2D GetSweptSphereBounds(const FVector& Start, const FVector& End, float Radius);
+
+	/** Whether the combatant capsule touches a sphere swept from Start to End */
+	static bool IsTouchingSweptSphere(const FCombatantGridEntry& Entry, const FVector& Start, const FVector& End, float Radius);
+
+	/** Calls Visitor for every live, collidable combatant around Bounds which is hostile to the instigator */
+	template <typename VisitorType>
+	void ForEachHostileCombatant(const FBox2D& Bounds, const AActor* Instigator, VisitorType&& Visitor) const;
+};
@@ -0,0 +1,105 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Structs/FSDamageInfo.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyDamagePipelineSubsystem.generated.h"
+
+class UMyCombatComponent;
+
+/** A damage event waiting for the end of the frame */
+struct FQueuedDamageEvent
+{
+	/** The damaged actor */
+	TWeakObjectPtr<AActor> Target;
+
+	/** Combat component of the damaged actor, resolved by the attacker */
+	TWeakObjectPtr<UMyCombatComponent> TargetCombatComponent;
+
+	/** The damaging actor */
+	TWeakObjectPtr<AActor> Attacker;
+
+	/** The damage dealt */
+	FSDamageInfo DamageInfo;
+
+	/** Unique id of the target, used as sort key */
+	uint32 TargetId = 0;
+};
+
+/**
+ *  =====================================================
+ *  Collects the damage dealt during a frame and applies it after all actors ticked.
+ *  Events are sorted by target and every target's hits are merged into a single
+ *  TakeDamage call, so each target reacts, writes its blackboard and reports to
+ *  perception once per frame regardless of how many attacks landed. Hits which differ
+ *  in whether they can be blocked or pierce invincibility are applied separately.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyDamagePipelineSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 *  Queues damage for the end of the frame, or applies it right away when Raider.Combat.DeferredDamage is off.
+	 *  @param Target - The actor taking damage, must implement the combat interface
+	 *  @param Attacker - The actor dealing damage
+	 *  @param DamageInfo - The damage info
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Damage")
+	void QueueDamage(AActor* Target, AActor* Attacker, const FSDamageInfo& DamageInfo);
+
+	/**
+	 *  Queues damage for a target whose combat component the caller already knows, so it is not looked up per hit.
+	 *  @param Target - The actor taking damage, must implement the combat interface
+	 *  @param TargetCombatComponent - Combat component of the target, may be null
+	 *  @param Attacker - The actor dealing damage
+	 *  @param DamageInfo - The damage info
+	 */
+	void QueueDamage(AActor* Target, UMyCombatComponent* TargetCombatComponent, AActor* Attacker, const FSDamageInfo& DamageInfo);
+
+	/** Applies all queued damage now */
+	void FlushDamage();
+
+	/** Number of damage events waiting for the end of the frame */
+	int32 GetNumPendingEvents() const { return PendingEvents.Num(); }
+
+	/**
+	 *  Merges a damage event into the accumulated damage of the same target, both must have the same defense key.
+	 *  Amounts add up, the most severe reaction wins and the damage forces an interrupt if any hit does.
+	 *  The damage type is left to the caller.
+	 *  @param Merged - The accumulated damage
+	 *  @param DamageInfo - The damage to add
+	 */
+	static void MergeDamage(FSDamageInfo& Merged, const FSDamageInfo& DamageInfo);
+
+	/**
+	 *  Combines whether the damage can be blocked and whether it damages invincible targets. Only hits with the
+	 *  same key are merged, so one unblockable hit can't carry the blockable ones past a block or i-frames.
+	 */
+	static uint8 GetDefenseKey(const FSDamageInfo& DamageInfo);
+
+private:
+	/** Events queued during the current frame */
+	TArray<FQueuedDamageEvent> PendingEvents;
+
+	/** Events being applied, new events queued by damage reactions go to the next frame */
+	TArray<FQueuedDamageEvent> ResolvingEvents;
+
+	/** Handle of the world post actor tick binding */
+	FDelegateHandle PostActorTickHandle;
+
+	/** Flushes the queue once all actors and tickable objects of the world ticked */
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Applies damage to a target and sends it to the clients when the target took it */
+	static void ApplyDamage(AActor* Target, UMyCombatComponent* TargetCombatComponent, AActor* Attacker, const FSDamageInfo& DamageInfo);
+};
@@ -0,0 +1,101 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "GenericTeamAgentInterface.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyTeamRegistrySubsystem.generated.h"
+
+/**
+ *  =====================================================
+ *  Registry of combatant team ids and the attitude between every pair of teams.
+ *  Combatants register their team once, afterwards team checks are a map lookup
+ *  and a matrix load instead of GetTeamNumber interface dispatches.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyTeamRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Number of team ids, team numbers are clamped into this range */
+	static constexpr int32 NumTeams = 256;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+/**
+ *	---------------------------------------------
+ *  Registration
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Registers the team of a combatant.
+	 *  @param Combatant - The combatant actor
+	 *  @param TeamNumber - Team number reported by the combat interface
+	 *  @return The compact team id stored for the combatant
+	 */
+	uint8 RegisterCombatant(const AActor* Combatant, int32 TeamNumber);
+
+	/** Removes a combatant from the registry */
+	void UnregisterCombatant(const AActor* Combatant);
+
+	/**
+	 *  Gets the registered team id of an actor.
+	 *  @param Actor - The actor to look up
+	 *  @param OutTeamId - Receives the team id
+	 *  @return false if the actor is not registered
+	 */
+	bool GetTeamId(const AActor* Actor, uint8& OutTeamId) const;
+
+	/** Converts a team number to a compact team id */
+	static uint8 ToTeamId(int32 TeamNumber);
+
+/**
+ *	---------------------------------------------
+ *  Attitude
+ *  ---------------------------------------------
+ */
+public:
+	/** Attitude of team A towards team B */
+	ETeamAttitude::Type GetAttitude(const uint8 TeamA, const uint8 TeamB) const
+	{
+		return static_cast<ETeamAttitude::Type>(Attitudes[TeamA * NumTeams + TeamB]);
+	}
+
+	/**
+	 *  Attitude of one registered actor towards another.
+	 *  @param Actor - The actor whose attitude is returned
+	 *  @param OtherActor - The actor being looked at
+	 *  @param OutAttitude - Receives the attitude
+	 *  @return false if either actor is not registered
+	 */
+	bool GetAttitude(const AActor* Actor, const AActor* OtherActor, ETeamAttitude::Type& OutAttitude) const;
+
+	/**
+	 *  Changes the attitude between two teams at runtime, in both directions.
+	 *  @param TeamA - First team number
+	 *  @param TeamB - Second team number
+	 *  @param Attitude - The new attitude
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Combat|Team")
+	void SetAttitude(int32 TeamA, int32 TeamB, TEnumAsByte<ETeamAttitude::Type> Attitude);
+
+	/** Blueprint access to the attitude between two team numbers */
+	UFUNCTION(BlueprintPure, Category = "Combat|Team", meta = (DisplayName = "Get Team Attitude"))
+	TEnumAsByte<ETeamAttitude::Type> K2_GetAttitude(int32 TeamA, int32 TeamB) const;
+
+private:
+	/** Attitude matrix indexed by [TeamA * NumTeams + TeamB] */
+	TArray<uint8> Attitudes;
+
+	/** Team id per registered combatant */
+	TMap<TObjectKey<AActor>, uint8> TeamIds;
+
+	/** Builds the attitude matrix from the team settings */
+	void BuildAttitudes();
+};
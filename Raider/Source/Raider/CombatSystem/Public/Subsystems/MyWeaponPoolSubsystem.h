@@ -0,0 +1,75 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatSystemAPI.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyWeaponPoolSubsystem.generated.h"
+
+class AWeaponBase;
+
+/** Weapon pool counters since the world started or the last reset */
+struct FWeaponPoolStats
+{
+	/** Weapons created because the pool was empty */
+	int32 NumSpawned = 0;
+
+	/** Weapons destroyed because the pool was full */
+	int32 NumDestroyed = 0;
+
+	/** Weapons handed out from the pool */
+	int32 NumReused = 0;
+
+	/** Weapons returned to the pool */
+	int32 NumReleased = 0;
+
+	/** World time the counters started at */
+	double StartTime = 0.0;
+};
+
+/**
+ *  =====================================================
+ *  Keeps unequipped weapon and shield actors per class, hidden and detached,
+ *  so equip and unequip cycles reuse actors instead of spawning and destroying them.
+ *  =====================================================
+ */
+UCLASS()
+class COMBATSYSTEM_API UMyWeaponPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 *  Takes a weapon of the class from the pool, or spawns one when the pool is empty.
+	 *  @param WeaponClass - The weapon class
+	 *  @param NewOwner - Owner of the weapon
+	 *  @return The visible, unattached weapon
+	 */
+	AWeaponBase* AcquireWeapon(TSubclassOf<AWeaponBase> WeaponClass, AActor* NewOwner);
+
+	/**
+	 *  Detaches and hides a weapon and keeps it for reuse. Weapons above the pool limit are destroyed.
+	 *  @param Weapon - The weapon to return
+	 */
+	void ReleaseWeapon(AWeaponBase* Weapon);
+
+	/** Pool counters */
+	const FWeaponPoolStats& GetStats() const { return Stats; }
+
+	/** Logs the pool counters and their rates */
+	void DumpStats() const;
+
+	/** Clears the pool counters */
+	void ResetStats();
+
+private:
+	/** Unequipped weapons per class */
+	TMap<TSubclassOf<AWeaponBase>, TArray<TWeakObjectPtr<AWeaponBase>>> PooledWeapons;
+
+	/** Pool counters */
+	FWeaponPoolStats Stats;
+};
@@ -0,0 +1,8 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Benchmark/RaiderBenchmarkCounters.h"
+
+int64 FRaiderBenchmarkCounters::NumDamageEvents = 0;
+int64 FRaiderBenchmarkCounters::NumPerceptionUpdates = 0;
+int64 FRaiderBenchmarkCounters::NumBehaviorTreeTicks = 0;
@@ -0,0 +1,27 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Benchmark/RaiderBenchmarkSettings.h"
+
+URaiderBenchmarkSettings::URaiderBenchmarkSettings()
+	: NumEnemies(60),
+	  WarmupSeconds(10.0f),
+	  DurationSeconds(120.0f),
+	  FixedFrameRate(30.0f),
+	  SampleInterval(1.0f),
+	  Seed(1337),
+	  MinSpawnDistance(1500.0f),
+	  MaxSpawnDistance(4000.0f),
+	  PlayerSearchRadius(8000.0f),
+	  PlayerAttackRange(200.0f),
+	  PlayerThinkInterval(0.25f)
+{
+	EnemyClasses.Add(TSoftClassPtr<AActor>(FSoftObjectPath(TEXT("/Game/Raider/Blueprints/NPC/BP_EnemyMelee.BP_EnemyMelee_C"))));
+	EnemyClasses.Add(TSoftClassPtr<AActor>(FSoftObjectPath(TEXT("/Game/Raider/Blueprints/NPC/BP_EnemyRanged.BP_EnemyRanged_C"))));
+	EnemyClasses.Add(TSoftClassPtr<AActor>(FSoftObjectPath(TEXT("/Game/Raider/Blueprints/NPC/BP_EnemyMage.BP_EnemyMage_C"))));
+}
+
+FName URaiderBenchmarkSettings::GetCategoryName() const
+{
+	return TEXT("Game");
+}
@@ -0,0 +1,531 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Benchmark/RaiderBenchmarkSubsystem.h"
+
+#include "NavigationSystem.h"
+#include "RaiderCharacter.h"
+#include "RaiderGameMode.h"
+#include "Benchmark/RaiderBenchmarkCounters.h"
+#include "Benchmark/RaiderBenchmarkSettings.h"
+#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "CoreGlobals.h"
+#include "Components/MyComboAttackComponent.h"
+#include "Components/MyCombatComponent.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "Interfaces/MyCombatInterface.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "NPC/NPCCharacterBase.h"
+#include "NPC/NPCPoolSubsystem.h"
+#include "NPC/NPCWaveSpawnerSubsystem.h"
+#include "Subsystems/MyCombatantGridSubsystem.h"
+
+bool URaiderBenchmarkSubsystem::IsBenchmarkRequested()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("RaiderBenchmark"));
+}
+
+bool URaiderBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return IsBenchmarkRequested() && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool URaiderBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void URaiderBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ReadOptions();
+
+	// Same seed and same simulated time per frame, however long the frame really took
+	RandomStream.Initialize(Seed);
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FixedFrameRate);
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddUObject(this, &URaiderBenchmarkSubsystem::OnBeginFrame);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &URaiderBenchmarkSubsystem::OnEndFrame);
+
+	UE_LOG(LogTemp, Display, TEXT("RaiderBenchmark: %d enemies, %.0f s warmup, %.0f s at %.0f fps, seed %d"),
+	       NumEnemies, WarmupSeconds, DurationSeconds, FixedFrameRate, Seed);
+}
+
+void URaiderBenchmarkSubsystem::Deinitialize()
+{
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	GetWorld()->OnTickFlush().Remove(TickFlushHandle);
+	GetWorld()->OnPostTickFlush().Remove(PostTickFlushHandle);
+
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	Super::Deinitialize();
+}
+
+TStatId URaiderBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URaiderBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void URaiderBenchmarkSubsystem::ReadOptions()
+{
+	const URaiderBenchmarkSettings* Settings = GetDefault<URaiderBenchmarkSettings>();
+	EnemyClasses = Settings->EnemyClasses;
+	NumEnemies = Settings->NumEnemies;
+	WarmupSeconds = Settings->WarmupSeconds;
+	DurationSeconds = Settings->DurationSeconds;
+	FixedFrameRate = Settings->FixedFrameRate;
+	SampleInterval = Settings->SampleInterval;
+	Seed = Settings->Seed;
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FParse::Value(CommandLine, TEXT("BenchmarkEnemies="), NumEnemies);
+	FParse::Value(CommandLine, TEXT("BenchmarkWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkDuration="), DurationSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkFPS="), FixedFrameRate);
+	FParse::Value(CommandLine, TEXT("BenchmarkSeed="), Seed);
+	FParse::Value(CommandLine, TEXT("BenchmarkClients="), NumClients);
+
+	// Comma separated class paths, such as /Game/Raider/Blueprints/NPC/BP_EnemyMelee.BP_EnemyMelee_C
+	FString EnemyClassList;
+	if (FParse::Value(CommandLine, TEXT("BenchmarkEnemyClasses="), EnemyClassList, false))
+	{
+		TArray<FString> EnemyClassPaths;
+		EnemyClassList.ParseIntoArray(EnemyClassPaths, TEXT(","));
+
+		EnemyClasses.Reset();
+		for (const FString& EnemyClassPath : EnemyClassPaths)
+		{
+			EnemyClasses.Add(TSoftClassPtr<AActor>(FSoftObjectPath(EnemyClassPath)));
+		}
+	}
+
+	// Named after the net mode once it is known, so listen and dedicated server runs don't overwrite each other
+	FParse::Value(CommandLine, TEXT("BenchmarkCSV="), CsvPath);
+
+	NumEnemies = FMath::Max(NumEnemies, 1);
+	WarmupSeconds = FMath::Max(WarmupSeconds, 0.0f);
+	DurationSeconds = FMath::Max(DurationSeconds, 1.0f);
+	FixedFrameRate = FMath::Max(FixedFrameRate, 1.0f);
+	SampleInterval = FMath::Max(SampleInterval, 0.1f);
+	NumClients = FMath::Max(NumClients, 0);
+}
+
+void URaiderBenchmarkSubsystem::StartBenchmark(ARaiderGameMode& GameMode)
+{
+	if (bIsRunning)
+	{
+		return;
+	}
+
+	GameModeRef = &GameMode;
+
+	// Replication is only measured once the clients are in, Tick tries again as they join
+	bIsWaitingForClients = GetNumConnectedClients() < NumClients;
+	if (bIsWaitingForClients)
+	{
+		UE_LOG(LogTemp, Display, TEXT("RaiderBenchmark: waiting for %d clients, %d connected"), NumClients, GetNumConnectedClients());
+		return;
+	}
+
+	Player = Cast<ARaiderCharacter>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
+
+	// A dedicated server has no local player, a stand-in fights the same way instead
+	if (!Player.IsValid() && IsRunningDedicatedServer())
+	{
+		Player = SpawnStandInPlayer(GameMode);
+	}
+
+	const TCHAR* NetMode = ToString(GetWorld()->GetNetMode());
+	if (CsvPath.IsEmpty())
+	{
+		CsvPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / FString::Printf(TEXT("RaiderBenchmark_%s_%s.csv"), NetMode, *FDateTime::Now().ToString());
+	}
+	UE_LOG(LogTemp, Display, TEXT("RaiderBenchmark: running as %s"), NetMode);
+
+	if (!Player.IsValid() || EnemyClasses.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("RaiderBenchmark: the map has no Raider player or no enemy class is set"));
+		FinishBenchmark();
+		return;
+	}
+
+	// The player lasts the whole run, so every run fights the same number of enemies
+	Player->CombatComponent->SetInvincible(true);
+
+	// Bound after the net driver, so the start is taken before it flushes, events call the latest binding first
+	TickFlushHandle = GetWorld()->OnTickFlush().AddUObject(this, &URaiderBenchmarkSubsystem::OnTickFlush);
+	PostTickFlushHandle = GetWorld()->OnPostTickFlush().AddUObject(this, &URaiderBenchmarkSubsystem::OnPostTickFlush);
+
+	bIsRunning = true;
+	StartTime = GetWorld()->GetTimeSeconds();
+	LastThinkTime = StartTime;
+
+	CsvLines.Reset();
+	CsvLines.Add(TEXT("Time,Frames,FrameMs,MaxFrameMs,GameThreadMs,NetTickMs,DamageEventsPerSec,PerceptionUpdatesPerSec,BTTicksPerSec,Combatants,UsedMemoryMB,PeakMemoryMB,BytesOutPerSec,BytesInPerSec,BytesOutPerNPCPerSec"));
+
+	// The enemy classes take turns, the game mode preloads each class before its wave
+	for (int32 ClassIndex = 0; ClassIndex < EnemyClasses.Num(); ++ClassIndex)
+	{
+		const int32 Share = NumEnemies / EnemyClasses.Num() + (ClassIndex < NumEnemies % EnemyClasses.Num() ? 1 : 0);
+
+		TArray<FTransform> SpawnTransforms;
+		MakeSpawnTransforms(Share, SpawnTransforms);
+		GameMode.StartEnemySpawnAt(EnemyClasses[ClassIndex], SpawnTransforms);
+	}
+}
+
+int32 URaiderBenchmarkSubsystem::GetNumConnectedClients() const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	return NetDriver ? NetDriver->ClientConnections.Num() : 0;
+}
+
+ARaiderCharacter* URaiderBenchmarkSubsystem::SpawnStandInPlayer(ARaiderGameMode& GameMode) const
+{
+	UClass* PawnClass = GameMode.GetDefaultPawnClassForController(nullptr);
+	const AActor* PlayerStart = GameMode.FindPlayerStart(nullptr);
+	if (!PawnClass || !PawnClass->IsChildOf<ARaiderCharacter>() || !PlayerStart)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ARaiderCharacter* Character = GetWorld()->SpawnActor<ARaiderCharacter>(PawnClass, PlayerStart->GetActorTransform(), SpawnParameters);
+	if (Character)
+	{
+		// Moved by an AI controller, SimpleMoveToLocation works the same with it
+		Character->SpawnDefaultController();
+	}
+	return Character;
+}
+
+void URaiderBenchmarkSubsystem::TopUpEnemies()
+{
+	ARaiderGameMode* GameMode = GameModeRef.Get();
+	const UNPCPoolSubsystem* NPCPool = GetWorld()->GetSubsystem<UNPCPoolSubsystem>();
+	const UNPCWaveSpawnerSubsystem* WaveSpawner = GetWorld()->GetSubsystem<UNPCWaveSpawnerSubsystem>();
+	if (!GameMode || !NPCPool || !WaveSpawner || WaveSpawner->GetNumPendingSpawns() > 0)
+	{
+		return;
+	}
+
+	// Only NPC classes are counted by the pool, other enemy classes are spawned once
+	for (int32 ClassIndex = 0; ClassIndex < EnemyClasses.Num(); ++ClassIndex)
+	{
+		UClass* EnemyClass = EnemyClasses[ClassIndex].Get();
+		if (!EnemyClass || !EnemyClass->IsChildOf<ANPCCharacterBase>())
+		{
+			continue;
+		}
+
+		const int32 Share = NumEnemies / EnemyClasses.Num() + (ClassIndex < NumEnemies % EnemyClasses.Num() ? 1 : 0);
+		const FNPCPoolStats* Stats = NPCPool->GetStats(EnemyClass);
+		const int32 NumMissing = Share - (Stats ? Stats->NumActive : 0);
+		if (NumMissing > 0)
+		{
+			TArray<FTransform> SpawnTransforms;
+			MakeSpawnTransforms(NumMissing, SpawnTransforms);
+			GameMode->StartEnemySpawnAt(EnemyClasses[ClassIndex], SpawnTransforms);
+		}
+	}
+}
+
+void URaiderBenchmarkSubsystem::MakeSpawnTransforms(const int32 Count, TArray<FTransform>& OutTransforms)
+{
+	const ARaiderCharacter* Character = Player.Get();
+	if (!Character)
+	{
+		return;
+	}
+
+	const URaiderBenchmarkSettings* Settings = GetDefault<URaiderBenchmarkSettings>();
+	const UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const FVector Center = Character->GetActorLocation();
+
+	OutTransforms.Reserve(OutTransforms.Num() + Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const float Angle = RandomStream.FRandRange(0.0f, UE_TWO_PI);
+		const float Distance = RandomStream.FRandRange(Settings->MinSpawnDistance, FMath::Max(Settings->MinSpawnDistance, Settings->MaxSpawnDistance));
+		FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Distance;
+
+		FNavLocation NavLocation;
+		if (NavigationSystem && NavigationSystem->ProjectPointToNavigation(Location, NavLocation, FVector(500.0f, 500.0f, 1000.0f)))
+		{
+			Location = NavLocation.Location + FVector(0.0f, 0.0f, Character->GetSimpleCollisionHalfHeight());
+		}
+
+		// Facing the player
+		OutTransforms.Emplace(FRotator(0.0f, FMath::RadiansToDegrees(Angle) + 180.0f, 0.0f), Location);
+	}
+}
+
+void URaiderBenchmarkSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bIsWaitingForClients)
+	{
+		if (ARaiderGameMode* GameMode = GameModeRef.Get(); GameMode && GetNumConnectedClients() >= NumClients)
+		{
+			StartBenchmark(*GameMode);
+		}
+		return;
+	}
+
+	if (bIsRunning)
+	{
+		DrivePlayer();
+	}
+}
+
+void URaiderBenchmarkSubsystem::DrivePlayer()
+{
+	ARaiderCharacter* Character = Player.Get();
+	const URaiderBenchmarkSettings* Settings = GetDefault<URaiderBenchmarkSettings>();
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (!Character || Now - LastThinkTime < Settings->PlayerThinkInterval)
+	{
+		return;
+	}
+	LastThinkTime = Now;
+
+	const UMyCombatantGridSubsystem* CombatantGrid = GetWorld()->GetSubsystem<UMyCombatantGridSubsystem>();
+	if (!CombatantGrid)
+	{
+		return;
+	}
+
+	// Closest living enemy
+	const FVector Location = Character->GetActorLocation();
+	TArray<AActor*> Enemies;
+	CombatantGrid->QuerySphere(Location, Settings->PlayerSearchRadius, Character, Enemies);
+
+	AActor* Target = nullptr;
+	float TargetDistanceSquared = MAX_flt;
+	for (AActor* Enemy : Enemies)
+	{
+		const float DistanceSquared = FVector::DistSquared2D(Location, Enemy->GetActorLocation());
+		if (DistanceSquared < TargetDistanceSquared && !IMyCombatInterface::Execute_IsDead(Enemy))
+		{
+			Target = Enemy;
+			TargetDistanceSquared = DistanceSquared;
+		}
+	}
+
+	if (!Target)
+	{
+		return;
+	}
+
+	AController* Controller = Character->GetController();
+	if (TargetDistanceSquared > FMath::Square(Settings->PlayerAttackRange))
+	{
+		UAIBlueprintHelperLibrary::SimpleMoveToLocation(Controller, Target->GetActorLocation());
+		return;
+	}
+
+	if (Controller)
+	{
+		Controller->StopMovement();
+	}
+
+	// Press and release, the press is buffered when a combo plays and continues it
+	Character->SetActorRotation((Target->GetActorLocation() - Location).GetSafeNormal2D().Rotation());
+	Character->ComboAttackComponent->HandleAttackInput(Target, EComboInput::Light);
+	Character->ComboAttackComponent->ReleaseAttackInput(EComboInput::Light);
+}
+
+void URaiderBenchmarkSubsystem::OnBeginFrame()
+{
+	LastFrameStartTime = FrameStartTime;
+	FrameStartTime = FPlatformTime::Seconds();
+}
+
+void URaiderBenchmarkSubsystem::OnEndFrame()
+{
+	if (!bIsRunning)
+	{
+		return;
+	}
+
+	const double Elapsed = GetWorld()->GetTimeSeconds() - StartTime;
+	if (!bIsSampling)
+	{
+		if (Elapsed >= WarmupSeconds)
+		{
+			bIsSampling = true;
+			BeginSample();
+		}
+		return;
+	}
+
+	// Wall clock from frame start to frame start, and the game thread time of the engine without its waits for the render thread
+	const double FrameMs = LastFrameStartTime > 0.0 ? (FrameStartTime - LastFrameStartTime) * 1000.0 : 0.0;
+	const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+
+	Sample.Seconds += GetWorld()->GetDeltaSeconds();
+	++Sample.NumFrames;
+	Sample.FrameMsSum += FrameMs;
+	Sample.MaxFrameMs = FMath::Max(Sample.MaxFrameMs, FrameMs);
+	Sample.GameThreadMsSum += GameThreadMs;
+	Sample.ActiveNPCFrames += GetNumActiveNPCs();
+
+	if (Sample.Seconds >= SampleInterval - UE_KINDA_SMALL_NUMBER)
+	{
+		EndSample();
+		TopUpEnemies();
+		BeginSample();
+	}
+
+	if (Elapsed >= WarmupSeconds + DurationSeconds)
+	{
+		FinishBenchmark();
+	}
+}
+
+void URaiderBenchmarkSubsystem::OnTickFlush(float DeltaSeconds)
+{
+	NetTickStartTime = FPlatformTime::Seconds();
+}
+
+void URaiderBenchmarkSubsystem::OnPostTickFlush()
+{
+	if (bIsSampling && NetTickStartTime > 0.0)
+	{
+		Sample.NetTickMsSum += (FPlatformTime::Seconds() - NetTickStartTime) * 1000.0;
+	}
+	NetTickStartTime = 0.0;
+}
+
+void URaiderBenchmarkSubsystem::BeginSample()
+{
+	Sample = FRaiderBenchmarkSample();
+	SampleDamageEvents = FRaiderBenchmarkCounters::NumDamageEvents;
+	SamplePerceptionUpdates = FRaiderBenchmarkCounters::NumPerceptionUpdates;
+	SampleBehaviorTreeTicks = FRaiderBenchmarkCounters::NumBehaviorTreeTicks;
+	GetNetBytes(SampleBytesOut, SampleBytesIn);
+}
+
+void URaiderBenchmarkSubsystem::EndSample()
+{
+	if (Sample.NumFrames == 0)
+	{
+		return;
+	}
+
+	Sample.NumDamageEvents = FRaiderBenchmarkCounters::NumDamageEvents - SampleDamageEvents;
+	Sample.NumPerceptionUpdates = FRaiderBenchmarkCounters::NumPerceptionUpdates - SamplePerceptionUpdates;
+	Sample.NumBehaviorTreeTicks = FRaiderBenchmarkCounters::NumBehaviorTreeTicks - SampleBehaviorTreeTicks;
+
+	// The totals are 32 bit and wrap, the unsigned difference stays right across one wrap
+	uint32 BytesOut = 0;
+	uint32 BytesIn = 0;
+	GetNetBytes(BytesOut, BytesIn);
+	Sample.NumBytesOut = BytesOut - SampleBytesOut;
+	Sample.NumBytesIn = BytesIn - SampleBytesIn;
+
+	Total.Seconds += Sample.Seconds;
+	Total.NumFrames += Sample.NumFrames;
+	Total.FrameMsSum += Sample.FrameMsSum;
+	Total.MaxFrameMs = FMath::Max(Total.MaxFrameMs, Sample.MaxFrameMs);
+	Total.GameThreadMsSum += Sample.GameThreadMsSum;
+	Total.NetTickMsSum += Sample.NetTickMsSum;
+	Total.NumDamageEvents += Sample.NumDamageEvents;
+	Total.NumPerceptionUpdates += Sample.NumPerceptionUpdates;
+	Total.NumBehaviorTreeTicks += Sample.NumBehaviorTreeTicks;
+	Total.NumBytesOut += Sample.NumBytesOut;
+	Total.NumBytesIn += Sample.NumBytesIn;
+	Total.ActiveNPCFrames += Sample.ActiveNPCFrames;
+
+	CsvLines.Add(FormatRow(FString::Printf(TEXT("%.2f"), Total.Seconds), Sample));
+}
+
+FString URaiderBenchmarkSubsystem::FormatRow(const FString& Label, const FRaiderBenchmarkSample& Row) const
+{
+	const UMyCombatantGridSubsystem* CombatantGrid = GetWorld()->GetSubsystem<UMyCombatantGridSubsystem>();
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	const double Seconds = FMath::Max(Row.Seconds, UE_KINDA_SMALL_NUMBER);
+	const int32 NumFrames = FMath::Max(Row.NumFrames, 1);
+	const double AverageNPCs = FMath::Max(static_cast<double>(Row.ActiveNPCFrames) / NumFrames, 1.0);
+
+	return FString::Printf(TEXT("%s,%d,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.1f,%d,%.1f,%.1f,%.0f,%.0f,%.1f"),
+	                       *Label, Row.NumFrames, Row.FrameMsSum / NumFrames, Row.MaxFrameMs, Row.GameThreadMsSum / NumFrames,
+	                       Row.NetTickMsSum / NumFrames,
+	                       Row.NumDamageEvents / Seconds, Row.NumPerceptionUpdates / Seconds, Row.NumBehaviorTreeTicks / Seconds,
+	                       CombatantGrid ? CombatantGrid->GetNumCombatants() : 0,
+	                       MemoryStats.UsedPhysical / (1024.0 * 1024.0), MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0),
+	                       Row.NumBytesOut / Seconds, Row.NumBytesIn / Seconds, Row.NumBytesOut / Seconds / AverageNPCs);
+}
+
+int32 URaiderBenchmarkSubsystem::GetNumActiveNPCs() const
+{
+	const UNPCPoolSubsystem* NPCPool = GetWorld()->GetSubsystem<UNPCPoolSubsystem>();
+	if (!NPCPool)
+	{
+		return 0;
+	}
+
+	int32 NumActive = 0;
+	for (const TSoftClassPtr<AActor>& EnemyClass : EnemyClasses)
+	{
+		UClass* LoadedClass = EnemyClass.Get();
+		const FNPCPoolStats* Stats = LoadedClass && LoadedClass->IsChildOf<ANPCCharacterBase>() ? NPCPool->GetStats(LoadedClass) : nullptr;
+		NumActive += Stats ? Stats->NumActive : 0;
+	}
+	return NumActive;
+}
+
+void URaiderBenchmarkSubsystem::GetNetBytes(uint32& OutBytesOut, uint32& OutBytesIn) const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	OutBytesOut = NetDriver ? NetDriver->OutTotalBytes : 0;
+	OutBytesIn = NetDriver ? NetDriver->InTotalBytes : 0;
+}
+
+void URaiderBenchmarkSubsystem::FinishBenchmark()
+{
+	if (bIsRunning)
+	{
+		EndSample();
+		CsvLines.Add(FormatRow(TEXT("Total"), Total));
+
+		if (FFileHelper::SaveStringArrayToFile(CsvLines, *CsvPath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("RaiderBenchmark: %d frames, %.3f ms game thread, %.1f damage events/s, written to %s"),
+			       Total.NumFrames, Total.GameThreadMsSum / FMath::Max(Total.NumFrames, 1),
+			       Total.NumDamageEvents / FMath::Max(Total.Seconds, UE_KINDA_SMALL_NUMBER), *CsvPath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("RaiderBenchmark: failed to write %s"), *CsvPath);
+		}
+	}
+
+	bIsRunning = false;
+	bIsSampling = false;
+
+	// PIE sessions are left running, they were started by hand
+	if (!GIsEditor)
+	{
+		FPlatformMisc::RequestExit(false, TEXT("RaiderBenchmark"));
+	}
+}
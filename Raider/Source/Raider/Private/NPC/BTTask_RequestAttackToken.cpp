@@ -0,0 +1,100 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/BTTask_RequestAttackToken.h"
+
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "Subsystems/MyAttackTokenSubsystem.h"
+
+UBTTask_RequestAttackToken::UBTTask_RequestAttackToken()
+	: AttackTokenNeeded(1),
+	  Priority(0)
+{
+	NodeName = "Request Attack Token";
+	TargetKey.SelectedKeyName = "AttackTarget";
+	TargetKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_RequestAttackToken, TargetKey), AActor::StaticClass());
+}
+
+EBTNodeResult::Type UBTTask_RequestAttackToken::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+	APawn* Pawn = AIController ? AIController->GetPawn() : nullptr;
+	const UBlackboardComponent* Blackboard = OwnerComp.GetBlackboardComponent();
+	AActor* Target = Blackboard ? Cast<AActor>(Blackboard->GetValue<UBlackboardKeyType_Object>(TargetKey.GetSelectedKeyID())) : nullptr;
+	UMyAttackTokenSubsystem* AttackTokens = OwnerComp.GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>();
+
+	if (!Pawn || !Target || !AttackTokens)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	FBTRequestAttackTokenMemory* Memory = CastInstanceNodeMemory<FBTRequestAttackTokenMemory>(NodeMemory);
+	Memory->Target = Target;
+
+	const EAttackTokenRequestResult Result = AttackTokens->RequestTokenOrWait(Target, Pawn, AttackTokenNeeded, Priority,
+		FOnAttackTokenResolved::CreateUObject(this, &UBTTask_RequestAttackToken::OnTokenResolved, TWeakObjectPtr<UBehaviorTreeComponent>(&OwnerComp)));
+
+	switch (Result)
+	{
+	case EAttackTokenRequestResult::Granted:
+		return EBTNodeResult::Succeeded;
+	case EAttackTokenRequestResult::Queued:
+		return EBTNodeResult::InProgress;
+	default:
+		return EBTNodeResult::Failed;
+	}
+}
+
+EBTNodeResult::Type UBTTask_RequestAttackToken::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	const FBTRequestAttackTokenMemory* Memory = CastInstanceNodeMemory<FBTRequestAttackTokenMemory>(NodeMemory);
+	const AAIController* AIController = OwnerComp.GetAIOwner();
+
+	if (UMyAttackTokenSubsystem* AttackTokens = OwnerComp.GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->CancelWait(Memory->Target.Get(), AIController ? AIController->GetPawn() : nullptr);
+	}
+
+	return EBTNodeResult::Aborted;
+}
+
+uint16 UBTTask_RequestAttackToken::GetInstanceMemorySize() const
+{
+	return sizeof(FBTRequestAttackTokenMemory);
+}
+
+void UBTTask_RequestAttackToken::InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, const EBTMemoryInit::Type InitType) const
+{
+	InitializeNodeMemory<FBTRequestAttackTokenMemory>(NodeMemory, InitType);
+}
+
+void UBTTask_RequestAttackToken::CleanupMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, const EBTMemoryClear::Type CleanupType) const
+{
+	CleanupNodeMemory<FBTRequestAttackTokenMemory>(NodeMemory, CleanupType);
+}
+
+void UBTTask_RequestAttackToken::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+
+	if (const UBlackboardData* BlackboardAsset = GetBlackboardAsset())
+	{
+		TargetKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+FString UBTTask_RequestAttackToken::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("%s: %d from %s"), *Super::GetStaticDescription(), AttackTokenNeeded, *TargetKey.SelectedKeyName.ToString());
+}
+
+void UBTTask_RequestAttackToken::OnTokenResolved(const bool bGranted, const TWeakObjectPtr<UBehaviorTreeComponent> OwnerComp)
+{
+	if (UBehaviorTreeComponent* BehaviorTree = OwnerComp.Get())
+	{
+		FinishLatentTask(*BehaviorTree, bGranted ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+	}
+}
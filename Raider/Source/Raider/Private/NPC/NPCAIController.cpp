@@ -5,22 +5,54 @@
 
 #include "BehaviorTree/BehaviorTree.h"
 #include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
+#include "Benchmark/RaiderBenchmarkCounters.h"
+#include "Components/MyCombatComponent.h"
 #include "GameFramework/Character.h"
 #include "Kismet/GameplayStatics.h"
+#include "NPC/NPCBehaviorTreeComponent.h"
 #include "NPC/NPCCharacterBase.h"
 #include "Perception/AISenseConfig_Damage.h"
 #include "Perception/AISenseConfig_Hearing.h"
 #include "Perception/AISenseConfig_Sight.h"
 #include "Perception/AIPerceptionComponent.h"
+#include "Perception/AISense_Hearing.h"
+#include "RaiderStats.h"
+#include "Subsystems/MyTeamRegistrySubsystem.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdReportNoise(
+	TEXT("Raider.AI.ReportNoise"),
+	TEXT("Reports a noise at the first player pawn so every NPC in hearing range perceives it. Optional loudness, defaults to 1."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APawn* PlayerPawn = World ? UGameplayStatics::GetPlayerPawn(World, 0) : nullptr;
+		if (PlayerPawn)
+		{
+			const float Loudness = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 1.0f;
+			UAISense_Hearing::ReportNoiseEvent(World, PlayerPawn->GetActorLocation(), Loudness, PlayerPawn);
+		}
+	}));
+
+DECLARE_CYCLE_STAT(TEXT("ActorsPerceptionUpdated"), STAT_RaiderActorsPerceptionUpdated, STATGROUP_RaiderAI);
+DECLARE_CYCLE_STAT(TEXT("TransitionTo"), STAT_RaiderTransitionTo, STATGROUP_RaiderAI);
 
 
 ANPCAIController::ANPCAIController()
+	: OwnerCharacter(nullptr),
+	  CurrentState(EAIState::Passive),
+	  PerceptionUpdateInterval(0.0f),
+	  LastPerceptionTime(0.0)
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 	
 	// Create blackboard component
 	BlackboardComponent = CreateDefaultSubobject<UBlackboardComponent>("BlackboardComponent");
+
+	// Behavior tree component whose tick rate follows the NPC LOD, used by RunBehaviorTree
+	BrainComponent = CreateDefaultSubobject<UNPCBehaviorTreeComponent>("BehaviorTreeComponent");
 	
 	// AI perception component
 	AIPerceptionComponent = CreateDefaultSubobject<UAIPerceptionComponent>("AIPerceptionComponent");
@@ -57,6 +89,8 @@ void ANPCAIController::BeginPlay()
 {
 	Super::BeginPlay();
 
+	TeamRegistry = GetWorld()->GetSubsystem<UMyTeamRegistrySubsystem>();
+
 	// Get owner character
 	OwnerCharacter = Cast<ANPCCharacterBase>(GetPawn());
 	if (!OwnerCharacter)
@@ -64,56 +98,240 @@ void ANPCAIController::BeginPlay()
 		return;
 	}
 
-	if (AIPerceptionComponent)
-	{
-		// Prevent multiple bindings by unbinding first
-		AIPerceptionComponent->OnPerceptionUpdated.RemoveDynamic(this, &ANPCAIController::OnPerceptionUpdated);
-
-		// Bind the delegates
-		AIPerceptionComponent->OnPerceptionUpdated.AddDynamic(this, &ANPCAIController::OnPerceptionUpdated);
-	}
+	// Perception updates arrive through ActorsPerceptionUpdated, the stimuli are indexed by sense id
+	SightSenseID = UAISense::GetSenseID<UAISense_Sight>();
+	HearingSenseID = UAISense::GetSenseID<UAISense_Hearing>();
+	DamageSenseID = UAISense::GetSenseID<UAISense_Damage>();
 	
 	// Run behavior tree
-	if (OwnerCharacter && OwnerCharacter->BehaviorTreeAsset)
+	UBehaviorTree* BehaviorTree = OwnerCharacter ? IMyPreloadInterface::ResolveAsset(OwnerCharacter->BehaviorTreeAsset) : nullptr;
+	if (BehaviorTree)
 	{
-		UseBlackboard(OwnerCharacter->BehaviorTreeAsset->BlackboardAsset, BlackboardComponent);
-		RunBehaviorTree(OwnerCharacter->BehaviorTreeAsset);
-		SetStateAsPassive();
+		UseBlackboard(BehaviorTree->BlackboardAsset, BlackboardComponent);
+		RunBehaviorTree(BehaviorTree);
+		CacheBlackboardKeys();
+		BlackboardComponent->RegisterObserver(AIStateKey, this,
+			FOnBlackboardChangeNotification::CreateUObject(this, &ANPCAIController::OnAIStateKeyChanged));
+
+		// Write the initial state even though the native state already matches
+		CurrentState = EAIState::Passive;
+		OwnerCharacter->SetReplicatedAIState(CurrentState);
+		BlackboardComponent->SetValue<UBlackboardKeyType_Enum>(AIStateKey, static_cast<uint8>(CurrentState));
+		INC_DWORD_STAT(STAT_RaiderBlackboardWrites);
 		SetCombatRange();
 	}
 }
 
-void ANPCAIController::SetStateAsPassive() const
+void ANPCAIController::SetStateAsPassive()
 {
-	BlackboardComponent->SetValueAsEnum("AIState", static_cast<uint8>(EAIState::Passive));
+	TransitionTo(EAIState::Passive);
 }
 
-void ANPCAIController::SetStateAsFrozen() const
+void ANPCAIController::SetStateAsFrozen()
 {
-	BlackboardComponent->SetValueAsEnum("AIState", static_cast<uint8>(EAIState::Frozen));
+	TransitionTo(EAIState::Frozen);
 }
 
 void ANPCAIController::SetStateAsAttacking(AActor* TargetActor)
 {
-	BlackboardComponent->SetValueAsEnum("AIState", static_cast<uint8>(EAIState::Attacking));
-	BlackboardComponent->SetValueAsObject("AttackTarget", TargetActor);
-	AttackTarget = TargetActor;
+	TransitionTo(EAIState::Attacking, TargetActor);
+}
+
+void ANPCAIController::SetStateAsInvestigating(const FVector Location)
+{
+	TransitionTo(EAIState::Investigating, nullptr, &Location);
+}
+
+void ANPCAIController::SetStateAsDead()
+{
+	TransitionTo(EAIState::Dead);
+}
+
+bool ANPCAIController::IsLegalTransition(const EAIState FromState, const EAIState ToState)
+{
+	// Rows are the current state, columns the next state, both in EAIState order
+	static constexpr bool LegalTransitions[5][5] =
+	{
+		//                    Passive Attacking Frozen Investigating Dead
+		/* Passive */       { true,   true,     true,  true,         true },
+		/* Attacking */     { true,   true,     true,  true,         true },
+		/* Frozen */        { true,   true,     true,  false,        true },
+		/* Investigating */ { true,   true,     true,  true,         true },
+		/* Dead */          { false,  false,    false, false,        true },
+	};
+
+	return LegalTransitions[static_cast<uint8>(FromState)][static_cast<uint8>(ToState)];
+}
+
+void ANPCAIController::DeactivateForPool()
+{
+	if (BrainComponent)
+	{
+		BrainComponent->StopLogic("Parked in the NPC pool");
+	}
+	StopMovement();
+	ClearFocus(EAIFocusPriority::Gameplay);
+
+	// Parked NPCs neither sense nor remember anything
+	if (AIPerceptionComponent)
+	{
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Sight::StaticClass(), false);
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Hearing::StaticClass(), false);
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Damage::StaticClass(), false);
+		AIPerceptionComponent->ForgetAll();
+	}
+
+	PendingPerceivedActors.Reset();
+	GetWorldTimerManager().ClearTimer(PendingPerceptionTimerHandle);
+}
+
+void ANPCAIController::ActivateFromPool()
+{
+	if (AIPerceptionComponent)
+	{
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Sight::StaticClass(), true);
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Hearing::StaticClass(), true);
+		AIPerceptionComponent->SetSenseEnabled(UAISense_Damage::StaticClass(), true);
+	}
+
+	// Dead is terminal for the state machine, a recycled NPC starts a new life instead of transitioning
+	CurrentState = EAIState::Passive;
+	AttackTarget = nullptr;
+
+	if (OwnerCharacter)
+	{
+		OwnerCharacter->SetReplicatedAIState(CurrentState);
+	}
+
+	if (BlackboardComponent && BlackboardComponent->GetBlackboardAsset())
+	{
+		BlackboardComponent->SetValue<UBlackboardKeyType_Enum>(AIStateKey, static_cast<uint8>(CurrentState));
+		BlackboardComponent->ClearValue(AttackTargetKey);
+		BlackboardComponent->ClearValue(LocationKey);
+		INC_DWORD_STAT_BY(STAT_RaiderBlackboardWrites, 3);
+	}
+
+	if (BrainComponent)
+	{
+		BrainComponent->RestartLogic();
+	}
+}
+
+FAIRequestID ANPCAIController::RequestMove(const FAIMoveRequest& MoveRequest, const FNavPathSharedPtr Path)
+{
+	const FAIRequestID RequestID = Super::RequestMove(MoveRequest, Path);
+	if (OwnerCharacter && RequestID.IsValid())
+	{
+		OwnerCharacter->SetAIMoving(true);
+	}
+	return RequestID;
 }
 
-void ANPCAIController::SetStateAsInvestigating(const FVector Location) const
+void ANPCAIController::OnMoveCompleted(const FAIRequestID RequestID, const FPathFollowingResult& Result)
 {
-	BlackboardComponent->SetValueAsEnum("AIState", static_cast<uint8>(EAIState::Investigating));
-	BlackboardComponent->SetValueAsVector("Location", Location);
+	Super::OnMoveCompleted(RequestID, Result);
+
+	// A move replaced by the next one keeps the NPC awake instead of letting it sleep for a moment
+	if (OwnerCharacter && !Result.HasFlag(FPathFollowingResultFlags::NewRequest))
+	{
+		OwnerCharacter->SetAIMoving(false);
+	}
 }
 
-void ANPCAIController::SetStateAsDead() const
+void ANPCAIController::CacheBlackboardKeys()
 {
-	BlackboardComponent->SetValueAsEnum("AIState", static_cast<uint8>(EAIState::Dead));
+	AIStateKey = BlackboardComponent->GetKeyID("AIState");
+	AttackTargetKey = BlackboardComponent->GetKeyID("AttackTarget");
+	LocationKey = BlackboardComponent->GetKeyID("Location");
 }
 
-EAIState ANPCAIController::GetCurrentState() const
+EBlackboardNotificationResult ANPCAIController::OnAIStateKeyChanged(const UBlackboardComponent& Blackboard, const FBlackboard::FKey ChangedKey)
 {
-	return static_cast<EAIState>(BlackboardComponent->GetValueAsEnum("AIState"));
+	const EAIState BlackboardState = static_cast<EAIState>(Blackboard.GetValue<UBlackboardKeyType_Enum>(ChangedKey));
+	if (BlackboardState == CurrentState)
+	{
+		return EBlackboardNotificationResult::ContinueObserving;
+	}
+
+	// Blackboard writes follow the same state machine as TransitionTo, e.g. a dead NPC stays dead
+	if (!IsLegalTransition(CurrentState, BlackboardState))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("%s reverts the illegal AI state transition %d -> %d written to the blackboard"),
+		       *GetName(), static_cast<uint8>(CurrentState), static_cast<uint8>(BlackboardState));
+		if (BlackboardComponent)
+		{
+			BlackboardComponent->SetValue<UBlackboardKeyType_Enum>(AIStateKey, static_cast<uint8>(CurrentState));
+		}
+		return EBlackboardNotificationResult::ContinueObserving;
+	}
+
+	CurrentState = BlackboardState;
+	if (OwnerCharacter)
+	{
+		OwnerCharacter->SetReplicatedAIState(BlackboardState);
+	}
+
+	return EBlackboardNotificationResult::ContinueObserving;
+}
+
+bool ANPCAIController::TransitionTo(const EAIState NewState, AActor* NewTarget, const FVector* NewLocation)
+{
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderTransitionTo);
+
+	if (NewState != CurrentState && !IsLegalTransition(CurrentState, NewState))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("%s ignores the illegal AI state transition %d -> %d"),
+		       *GetName(), static_cast<uint8>(CurrentState), static_cast<uint8>(NewState));
+		return false;
+	}
+
+	const bool bStateChanged = NewState != CurrentState;
+	const bool bTargetChanged = NewState == EAIState::Attacking && NewTarget != AttackTarget;
+	const bool bLocationChanged = NewState == EAIState::Investigating && NewLocation && BlackboardComponent &&
+		!FVector::PointsAreNear(BlackboardComponent->GetValue<UBlackboardKeyType_Vector>(LocationKey), *NewLocation, InvestigateLocationTolerance);
+
+	// Repeated stimuli don't touch the blackboard, so the behavior tree isn't re-evaluated
+	if (!bStateChanged && !bTargetChanged && !bLocationChanged)
+	{
+		return true;
+	}
+
+	CurrentState = NewState;
+	if (OwnerCharacter)
+	{
+		OwnerCharacter->SetReplicatedAIState(NewState);
+	}
+
+	if (bTargetChanged)
+	{
+		AttackTarget = NewTarget;
+	}
+
+	if (!BlackboardComponent)
+	{
+		return true;
+	}
+
+	INC_DWORD_STAT_BY(STAT_RaiderBlackboardWrites, bStateChanged + bTargetChanged + bLocationChanged);
+	BlackboardComponent->PauseObserverNotifications();
+
+	if (bStateChanged)
+	{
+		BlackboardComponent->SetValue<UBlackboardKeyType_Enum>(AIStateKey, static_cast<uint8>(NewState));
+	}
+
+	if (bTargetChanged)
+	{
+		BlackboardComponent->SetValue<UBlackboardKeyType_Object>(AttackTargetKey, NewTarget);
+	}
+
+	if (bLocationChanged)
+	{
+		BlackboardComponent->SetValue<UBlackboardKeyType_Vector>(LocationKey, *NewLocation);
+	}
+
+	BlackboardComponent->ResumeObserverNotifications(true);
+	return true;
 }
 
 void ANPCAIController::SetCombatRange() const
@@ -137,76 +355,145 @@ void ANPCAIController::SetCombatRange() const
 	
 	BlackboardComponent->SetValueAsFloat("AttackRadius", AttackRadius);
 	BlackboardComponent->SetValueAsFloat("DefendRadius", DefendRadius);
+	INC_DWORD_STAT_BY(STAT_RaiderBlackboardWrites, 2);
 
 }
 
-void ANPCAIController::OnPerceptionUpdated(const TArray<AActor*>& UpdatedActors)
+void ANPCAIController::ActorsPerceptionUpdated(const TArray<AActor*>& UpdatedActors)
 {
-	for (AActor* Actor : UpdatedActors)
+	RAIDER_SCOPE_CYCLE_COUNTER(STAT_RaiderActorsPerceptionUpdated);
+	INC_DWORD_STAT_BY(STAT_RaiderPerceptionEvents, UpdatedActors.Num());
+
+	Super::ActorsPerceptionUpdated(UpdatedActors);
+
+	FRaiderBenchmarkCounters::NumPerceptionUpdates += UpdatedActors.Num();
+
+	if (!OwnerCharacter || !AIPerceptionComponent)
+	{
+		return;
+	}
+
+	// Within the interval the actors wait, their perception record is read once the interval has passed
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double NextPerceptionTime = LastPerceptionTime + PerceptionUpdateInterval;
+	if (PerceptionUpdateInterval > 0.0f && Now < NextPerceptionTime)
 	{
-		if (Actor)
+		for (AActor* Actor : UpdatedActors)
 		{
-			FAIStimulus Stimulus;
-
-			if (CanSenseActor(Actor, EAISense::Sight,Stimulus))
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("%s AI Sees Actor: %s"), *OwnerCharacter->GetName(), *Actor->GetName());
-				HandleSenseSight(Actor);
-			}
-
-			if (CanSenseActor(Actor, EAISense::Hearing, Stimulus))
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("%s AI Heard Actor: %s"), *OwnerCharacter->GetName(), *Actor->GetName());
-				HandleSenseSound(Stimulus.StimulusLocation);
-			}
-
-			if (CanSenseActor(Actor, EAISense::Damage, Stimulus))
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("%s AI Detected Damage from Actor: %s"), *OwnerCharacter->GetName(), *Actor->GetName());
-				HandleSenseDamage(Actor);
-			}
+			PendingPerceivedActors.AddUnique(Actor);
 		}
+
+		if (!GetWorldTimerManager().IsTimerActive(PendingPerceptionTimerHandle))
+		{
+			GetWorldTimerManager().SetTimer(PendingPerceptionTimerHandle, this, &ANPCAIController::FlushPendingPerception,
+			                                NextPerceptionTime - Now, false);
+		}
+		return;
+	}
+
+	LastPerceptionTime = Now;
+	for (AActor* Actor : UpdatedActors)
+	{
+		HandlePerceivedActor(Actor);
 	}
 }
 
-bool ANPCAIController::CanSenseActor(AActor* Actor, const EAISense SenseType, FAIStimulus& OutStimulus) const
+void ANPCAIController::SetPerceptionUpdateInterval(const float Interval)
 {
-	if (!Actor || !AIPerceptionComponent)
+	PerceptionUpdateInterval = Interval;
+
+	// A shorter interval may already have passed
+	if (GetWorldTimerManager().IsTimerActive(PendingPerceptionTimerHandle) &&
+		GetWorld()->GetTimeSeconds() >= LastPerceptionTime + PerceptionUpdateInterval)
 	{
-		return false;
+		GetWorldTimerManager().ClearTimer(PendingPerceptionTimerHandle);
+		FlushPendingPerception();
 	}
+}
 
-	FActorPerceptionBlueprintInfo PerceptionInfo;
-	AIPerceptionComponent->GetActorsPerception(Actor, PerceptionInfo);
+void ANPCAIController::FlushPendingPerception()
+{
+	LastPerceptionTime = GetWorld()->GetTimeSeconds();
 
-	for (const FAIStimulus& Stimulus : PerceptionInfo.LastSensedStimuli)
+	// The handlers may change the state but never add pending actors
+	for (const TWeakObjectPtr<AActor>& Actor : PendingPerceivedActors)
 	{
-		if ((SenseType == EAISense::Sight && Stimulus.Type == UAISense::GetSenseID<UAISense_Sight>()) ||
-			(SenseType == EAISense::Hearing && Stimulus.Type == UAISense::GetSenseID<UAISense_Hearing>()) ||
-			(SenseType == EAISense::Damage && Stimulus.Type == UAISense::GetSenseID<UAISense_Damage>()))
+		HandlePerceivedActor(Actor.Get());
+	}
+	PendingPerceivedActors.Reset();
+}
+
+void ANPCAIController::HandlePerceivedActor(AActor* Actor)
+{
+	if (!OwnerCharacter || !AIPerceptionComponent)
+	{
+		return;
+	}
+
+	const FActorPerceptionInfo* PerceptionInfo = Actor ? AIPerceptionComponent->GetActorInfo(*Actor) : nullptr;
+	if (!PerceptionInfo)
+	{
+		return;
+	}
+
+	// Classify the stimuli in one pass, the dispatch order stays sight, hearing, damage
+	bool bSensedSight = false;
+	bool bSensedHearing = false;
+	bool bSensedDamage = false;
+	FVector HearingLocation = FVector::ZeroVector;
+
+	for (const FAIStimulus& Stimulus : PerceptionInfo->LastSensedStimuli)
+	{
+		if (!Stimulus.WasSuccessfullySensed())
+		{
+			continue;
+		}
+
+		if (Stimulus.Type == SightSenseID)
+		{
+			bSensedSight = true;
+		}
+		else if (Stimulus.Type == HearingSenseID)
+		{
+			bSensedHearing = true;
+			HearingLocation = Stimulus.StimulusLocation;
+		}
+		else if (Stimulus.Type == DamageSenseID)
 		{
-			OutStimulus = Stimulus;
-			return Stimulus.WasSuccessfullySensed();
+			bSensedDamage = true;
 		}
 	}
-	return false;
+
+	// The handlers change the AI state, the perception record is not touched after this point
+	if (bSensedSight)
+	{
+		HandleSenseSight(Actor);
+	}
+
+	if (bSensedHearing)
+	{
+		HandleSenseSound(HearingLocation);
+	}
+
+	if (bSensedDamage)
+	{
+		HandleSenseDamage(Actor);
+	}
 }
 
 void ANPCAIController::HandleSenseSight(AActor* Actor)
 {
-	EAIState CurrentState = GetCurrentState();
 	if (CurrentState == EAIState::Passive || CurrentState == EAIState::Investigating)
 	{
-		if (!IsOnSameTeam(Actor))
+		if (IsHostile(Actor))
 		{
 			SetStateAsAttacking(Actor);
 		}
 	}
 }
 
-void ANPCAIController::HandleSenseSound(const FVector& Location) const
+void ANPCAIController::HandleSenseSound(const FVector& Location)
 {
-	EAIState CurrentState = GetCurrentState();
 	if (CurrentState == EAIState::Passive || CurrentState == EAIState::Investigating)
 	{
 		SetStateAsInvestigating(Location);
@@ -215,10 +502,9 @@ void ANPCAIController::HandleSenseSound(const FVector& Location) const
 
 void ANPCAIController::HandleSenseDamage(AActor* Actor)
 {
-	EAIState CurrentState = GetCurrentState();
 	if (CurrentState != EAIState::Dead)
 	{
-		if (!IsOnSameTeam(Actor))
+		if (IsHostile(Actor))
 		{
 			SetStateAsAttacking(Actor);
 		}
@@ -227,6 +513,13 @@ void ANPCAIController::HandleSenseDamage(AActor* Actor)
 
 bool ANPCAIController::IsOnSameTeam(AActor* OtherActor) const
 {
+	// Registered combatants are answered by the attitude matrix
+	ETeamAttitude::Type Attitude;
+	if (TeamRegistry && TeamRegistry->GetAttitude(GetPawn(), OtherActor, Attitude))
+	{
+		return Attitude == ETeamAttitude::Friendly;
+	}
+
 	if (!OtherActor || !OtherActor->GetClass()->ImplementsInterface(UMyCombatInterface::StaticClass()))
 	{
 		return false;
@@ -243,3 +536,16 @@ bool ANPCAIController::IsOnSameTeam(AActor* OtherActor) const
 	
 	return (MyTeam == OtherTeam);
 }
+
+bool ANPCAIController::IsHostile(AActor* OtherActor) const
+{
+	// The own team id is cached by the combat component, only the perceived actor's team is looked up
+	const UMyCombatComponent* CombatComponent = OwnerCharacter ? OwnerCharacter->CombatComponent : nullptr;
+	uint8 OtherTeamId;
+	if (TeamRegistry && CombatComponent && CombatComponent->IsTeamRegistered() && TeamRegistry->GetTeamId(OtherActor, OtherTeamId))
+	{
+		return TeamRegistry->GetAttitude(CombatComponent->GetTeamId(), OtherTeamId) == ETeamAttitude::Hostile;
+	}
+
+	return !IsOnSameTeam(OtherActor);
+}
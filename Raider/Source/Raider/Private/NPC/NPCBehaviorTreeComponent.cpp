@@ -0,0 +1,19 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCBehaviorTreeComponent.h"
+
+#include "Benchmark/RaiderBenchmarkCounters.h"
+
+void UNPCBehaviorTreeComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	++FRaiderBenchmarkCounters::NumBehaviorTreeTicks;
+
+	// The tree rescheduled itself, stretch the interval unless it was disabled
+	if (MinTickInterval > 0.0f && IsComponentTickEnabled() && GetComponentTickInterval() < MinTickInterval)
+	{
+		SetComponentTickIntervalAndCooldown(MinTickInterval);
+	}
+}
@@ -4,18 +4,36 @@
 #include "NPC/NPCCharacterBase.h"
 
 #include "AIController.h"
+#include "Animation/AnimMontage.h"
 #include "BrainComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/WidgetComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "NPC/NPCAIController.h"
+#include "NPC/NPCLODSubsystem.h"
+#include "NPC/NPCPoolSubsystem.h"
 #include "NPC/Enums/ECharacterMovementState.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Perception/AISense_Damage.h"
+#include "Subsystems/MyAttackTokenSubsystem.h"
+#include "TimerManager.h"
 #include "../CombatSystem/Public/Components//MyCombatComponent.h"
 #include "../CombatSystem/Public/Components/MyHealthComponent.h"
+#include "../CombatSystem/Public/Components/MyMontageDispatcherComponent.h"
+
+static TAutoConsoleVariable<bool> CVarNPCNetDormancy(
+	TEXT("Raider.AI.NetDormancy"),
+	true,
+	TEXT("Whether passive NPCs which stand and dead NPCs go net dormant, so the server skips them until their state changes."));
 
 // Sets default values
 ANPCCharacterBase::ANPCCharacterBase()
-	: TeamNumber(1)
+	: TeamNumber(1),
+	  CorpseLifeSpan(10.0f),
+	  bIsPooled(false),
+	  DefaultCapsuleCollision(ECollisionEnabled::QueryAndPhysics)
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -37,6 +55,67 @@ ANPCCharacterBase::ANPCCharacterBase()
 	// Health component
 	HealthComponent = CreateDefaultSubobject<UMyHealthComponent>("HealthComponent");
 
+	// Montage dispatcher component
+	MontageDispatcherComponent = CreateDefaultSubobject<UMyMontageDispatcherComponent>("MontageDispatcherComponent");
+
+}
+
+void ANPCCharacterBase::GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	AddPreloadAsset(OutAssets, BehaviorTreeAsset);
+}
+
+void ANPCCharacterBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ANPCCharacterBase, ReplicatedAIState, Params);
+}
+
+void ANPCCharacterBase::SetReplicatedAIState(const EAIState NewState)
+{
+	if (ReplicatedAIState != NewState)
+	{
+		ReplicatedAIState = NewState;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ANPCCharacterBase, ReplicatedAIState, this);
+	}
+
+	UpdateNetDormancy();
+}
+
+void ANPCCharacterBase::SetAIMoving(const bool bMoving)
+{
+	if (bIsAIMoving != bMoving)
+	{
+		bIsAIMoving = bMoving;
+		UpdateNetDormancy();
+	}
+}
+
+void ANPCCharacterBase::UpdateNetDormancy()
+{
+	if (!HasAuthority() || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	const bool bCanSleep = CVarNPCNetDormancy.GetValueOnGameThread() &&
+		(ReplicatedAIState == EAIState::Dead || (ReplicatedAIState == EAIState::Passive && !bIsAIMoving));
+
+	const ENetDormancy NewDormancy = bCanSleep ? DORM_DormantAll : DORM_Awake;
+
+	// An awake NPC sends its changes anyway, only a dormant one or one about to fall asleep flushes what changed
+	if (NetDormancy > DORM_Awake || NewDormancy != NetDormancy)
+	{
+		FlushNetDormancy();
+	}
+
+	if (NewDormancy != NetDormancy)
+	{
+		SetNetDormancy(NewDormancy);
+	}
 }
 
 // Called when the game starts or when spawned
@@ -65,6 +144,37 @@ void ANPCCharacterBase::BeginPlay()
 		// Bind the delegates
 		HealthComponent->OnDeath.AddDynamic(this, &ANPCCharacterBase::OnDeathHandler);
 	}
+
+	// Death changes both, pooled NPCs get them back when reactivated
+	DefaultCapsuleCollision = GetCapsuleComponent()->GetCollisionEnabled();
+	DefaultMeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+
+	// Health bars are never drawn on a dedicated server, hidden instead of destroyed as Blueprints still update them
+	if (IsRunningDedicatedServer())
+	{
+		TInlineComponentArray<UWidgetComponent*> WidgetComponents(this);
+		for (UWidgetComponent* WidgetComponent : WidgetComponents)
+		{
+			WidgetComponent->SetVisibility(false);
+			WidgetComponent->SetComponentTickEnabled(false);
+		}
+	}
+
+	// Lower the update rate while far from the players
+	if (UNPCLODSubsystem* NPCLOD = GetWorld()->GetSubsystem<UNPCLODSubsystem>())
+	{
+		NPCLOD->RegisterNPC(this);
+	}
+}
+
+void ANPCCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UNPCLODSubsystem* NPCLOD = GetWorld()->GetSubsystem<UNPCLODSubsystem>())
+	{
+		NPCLOD->UnregisterNPC(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -154,7 +264,7 @@ void ANPCCharacterBase::OnDamageReactHandler_Implementation(EDamageReact DamageR
 	GetCharacterMovement()->StopMovementImmediately();
 
 	// Update behavior tree to frozen
-	if (const ANPCAIController* AIController = Cast<ANPCAIController>(GetInstigatorController()))
+	if (ANPCAIController* AIController = Cast<ANPCAIController>(GetInstigatorController()))
 	{
 		AIController->SetStateAsFrozen();
 	}
@@ -262,9 +372,15 @@ void ANPCCharacterBase::OnDeathHandler_Implementation()
 			IMyCombatInterface::Execute_ReturnAttackToken(AttackTarget, this, 1);
 		}
 	}
+
+	// Drop every other lease and queued wait, the dead NPC won't attack again
+	if (UMyAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UMyAttackTokenSubsystem>())
+	{
+		AttackTokens->ReleaseAttacker(this);
+	}
 	
 	// Stop AI logic if the actor has an AI controller
-	if (const ANPCAIController* AIController = Cast<ANPCAIController>(GetInstigatorController()))
+	if (ANPCAIController* AIController = Cast<ANPCAIController>(GetInstigatorController()))
 	{
 		AIController->SetStateAsDead();
 		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
@@ -276,9 +392,9 @@ void ANPCCharacterBase::OnDeathHandler_Implementation()
 	//Play death animation
 	if (HealthComponent)
 	{
-		if (HealthComponent->DeathMontage)
+		if (UAnimMontage* DeathMontage = IMyPreloadInterface::ResolveAsset(HealthComponent->DeathMontage))
 		{
-			HealthComponent->PlayDeathMontage(HealthComponent->DeathMontage);
+			HealthComponent->PlayDeathMontage(DeathMontage);
 		}
 		else
 		{
@@ -291,8 +407,102 @@ void ANPCCharacterBase::OnDeathHandler_Implementation()
 	GetCharacterMovement()->DisableMovement();
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	// Destroy the actor after a delay
-	Owner->SetLifeSpan(10.0f);
+	// Recycle the actor after a delay
+	GetWorldTimerManager().SetTimer(CorpseTimerHandle, this, &ANPCCharacterBase::OnCorpseExpired, CorpseLifeSpan);
+}
+
+void ANPCCharacterBase::OnCorpseExpired()
+{
+	if (UNPCPoolSubsystem* NPCPool = GetWorld()->GetSubsystem<UNPCPoolSubsystem>())
+	{
+		NPCPool->ReleaseNPC(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void ANPCCharacterBase::DeactivateForPool()
+{
+	GetWorldTimerManager().ClearTimer(CorpseTimerHandle);
+
+	// Leave the LOD first, it restores the full rate setup which is switched off below
+	if (UNPCLODSubsystem* NPCLOD = GetWorld()->GetSubsystem<UNPCLODSubsystem>())
+	{
+		NPCLOD->UnregisterNPC(this);
+	}
+
+	if (ANPCAIController* AIController = Cast<ANPCAIController>(GetController()))
+	{
+		AIController->DeactivateForPool();
+	}
+
+	if (MontageDispatcherComponent)
+	{
+		MontageDispatcherComponent->StopMontages(0.0f);
+	}
+
+	// Weapons are attached actors which wouldn't be hidden with the NPC, they wait in the weapon pool
+	if (CombatComponent)
+	{
+		CombatComponent->ResetCombatState();
+	}
+
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->StopMovementImmediately();
+	Movement->DisableMovement();
+	Movement->SetComponentTickEnabled(false);
+
+	// Take the mesh out of the ragdoll and put it back on the capsule
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	MeshComponent->SetSimulatePhysics(false);
+	MeshComponent->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	MeshComponent->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+	MeshComponent->SetCollisionProfileName(DefaultMeshCollisionProfile);
+	MeshComponent->SetComponentTickEnabled(false);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	bIsPooled = true;
+
+	// Parked NPCs usually sleep already, clients still need to hide them
+	FlushNetDormancy();
+}
+
+void ANPCCharacterBase::ActivateFromPool(const FTransform& SpawnTransform)
+{
+	bIsPooled = false;
+
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetCapsuleComponent()->SetCollisionEnabled(DefaultCapsuleCollision);
+	GetMesh()->SetComponentTickEnabled(true);
+
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->SetComponentTickEnabled(true);
+	Movement->SetDefaultMovementMode();
+
+	if (HealthComponent)
+	{
+		HealthComponent->ResetHealth();
+	}
+
+	if (ANPCAIController* AIController = Cast<ANPCAIController>(GetController()))
+	{
+		AIController->ActivateFromPool();
+	}
+
+	if (UNPCLODSubsystem* NPCLOD = GetWorld()->GetSubsystem<UNPCLODSubsystem>())
+	{
+		NPCLOD->RegisterNPC(this);
+	}
+
+	// The new location and health reach clients even when the NPC keeps sleeping as passive
+	FlushNetDormancy();
 }
 
 AActor* ANPCCharacterBase::GetPatrolRoute_Implementation()
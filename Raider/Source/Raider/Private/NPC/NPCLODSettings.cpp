@@ -0,0 +1,49 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCLODSettings.h"
+
+UNPCLODSettings::UNPCLODSettings()
+	: UpdateInterval(0.5f),
+	  HysteresisDistance(300.0f),
+	  OffscreenDistanceScale(2.0f)
+{
+	// Near, full rate
+	FNPCLODBucket& Near = Buckets.AddDefaulted_GetRef();
+	Near.MaxDistance = 2000.0f;
+
+	// Mid, a few frames between updates
+	FNPCLODBucket& Mid = Buckets.AddDefaulted_GetRef();
+	Mid.MaxDistance = 5000.0f;
+	Mid.ActorTickInterval = 0.1f;
+	Mid.BehaviorTreeTickInterval = 0.1f;
+	Mid.MovementTickInterval = 0.033f;
+	Mid.AnimationTickInterval = 0.033f;
+	Mid.PerceptionUpdateInterval = 0.1f;
+
+	// Far, only animated while rendered
+	FNPCLODBucket& Far = Buckets.AddDefaulted_GetRef();
+	Far.MaxDistance = 10000.0f;
+	Far.ActorTickInterval = 0.25f;
+	Far.BehaviorTreeTickInterval = 0.25f;
+	Far.MovementTickInterval = 0.1f;
+	Far.AnimationTickInterval = 0.1f;
+	Far.PerceptionUpdateInterval = 0.25f;
+	Far.AnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+
+	// Dormant, no sight
+	FNPCLODBucket& Dormant = Buckets.AddDefaulted_GetRef();
+	Dormant.MaxDistance = UE_BIG_NUMBER;
+	Dormant.ActorTickInterval = 0.5f;
+	Dormant.BehaviorTreeTickInterval = 0.5f;
+	Dormant.MovementTickInterval = 0.25f;
+	Dormant.AnimationTickInterval = 0.25f;
+	Dormant.PerceptionUpdateInterval = 0.5f;
+	Dormant.AnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	Dormant.bEnableSight = false;
+}
+
+FName UNPCLODSettings::GetCategoryName() const
+{
+	return TEXT("Game");
+}
@@ -0,0 +1,248 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCLODSubsystem.h"
+
+#include "AIController.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "NPC/NPCAIController.h"
+#include "NPC/NPCBehaviorTreeComponent.h"
+#include "NPC/NPCCharacterBase.h"
+#include "NPC/NPCLODSettings.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "Perception/AISense_Sight.h"
+
+static TAutoConsoleVariable<bool> CVarNPCLOD(
+	TEXT("Raider.AI.LOD"),
+	true,
+	TEXT("Lower the update rate of NPCs far from every player. When off, every NPC runs at full rate."));
+
+static FAutoConsoleCommandWithWorld CmdDumpNPCLOD(
+	TEXT("Raider.AI.DumpLOD"),
+	TEXT("Prints the number of NPCs in each LOD bucket."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UNPCLODSubsystem* NPCLOD = World ? World->GetSubsystem<UNPCLODSubsystem>() : nullptr)
+		{
+			NPCLOD->DumpStats();
+		}
+	}));
+
+void UNPCLODSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Settings = GetDefault<UNPCLODSettings>();
+}
+
+void UNPCLODSubsystem::Deinitialize()
+{
+	NPCs.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UNPCLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNPCLODSubsystem, STATGROUP_Tickables);
+}
+
+void UNPCLODSubsystem::RegisterNPC(ANPCCharacterBase* Character)
+{
+	if (Character && !NPCs.ContainsByPredicate([Character](const FNPCLODEntry& Entry) { return Entry.Character == Character; }))
+	{
+		NPCs.Add({ Character, INDEX_NONE });
+	}
+}
+
+void UNPCLODSubsystem::UnregisterNPC(ANPCCharacterBase* Character)
+{
+	const int32 EntryIndex = NPCs.IndexOfByPredicate([Character](const FNPCLODEntry& Entry) { return Entry.Character == Character; });
+	if (EntryIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (NPCs[EntryIndex].Bucket != INDEX_NONE)
+	{
+		ApplyBucket(Character, INDEX_NONE);
+	}
+
+	NPCs.RemoveAtSwap(EntryIndex);
+}
+
+void UNPCLODSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const bool bLODEnabled = CVarNPCLOD.GetValueOnGameThread();
+	if (NPCs.Num() == 0 || !Settings || Settings->Buckets.Num() == 0)
+	{
+		return;
+	}
+
+	if (bLODEnabled)
+	{
+		GatherViewLocations();
+	}
+
+	// Evaluate a slice per frame so every NPC is visited once per update interval
+	PendingEvaluations += NPCs.Num() * DeltaTime / FMath::Max(Settings->UpdateInterval, UE_KINDA_SMALL_NUMBER);
+	const int32 NumEvaluations = FMath::Min(FMath::FloorToInt32(PendingEvaluations), NPCs.Num());
+	PendingEvaluations -= NumEvaluations;
+
+	for (int32 Evaluation = 0; Evaluation < NumEvaluations && NPCs.Num() > 0; ++Evaluation)
+	{
+		if (NextEntryIndex >= NPCs.Num())
+		{
+			NextEntryIndex = 0;
+		}
+
+		FNPCLODEntry& Entry = NPCs[NextEntryIndex];
+		ANPCCharacterBase* Character = Entry.Character.Get();
+		if (!Character)
+		{
+			NPCs.RemoveAtSwap(NextEntryIndex);
+			continue;
+		}
+
+		const int32 NewBucket = bLODEnabled && ViewLocations.Num() > 0 ? EvaluateBucket(Character, Entry.Bucket) : 0;
+		if (NewBucket != Entry.Bucket)
+		{
+			ApplyBucket(Character, NewBucket);
+			Entry.Bucket = NewBucket;
+		}
+
+		++NextEntryIndex;
+	}
+}
+
+void UNPCLODSubsystem::GatherViewLocations()
+{
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		if (const APlayerController* PlayerController = Iterator->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+}
+
+int32 UNPCLODSubsystem::EvaluateBucket(const ANPCCharacterBase* Character, const int32 CurrentBucket) const
+{
+	const FVector Location = Character->GetActorLocation();
+
+	float MinDistanceSquared = UE_BIG_NUMBER;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, static_cast<float>(FVector::DistSquared(Location, ViewLocation)));
+	}
+
+	// Nothing is rendered on a dedicated server, only the distance counts there
+	float Distance = FMath::Sqrt(MinDistanceSquared);
+	if (!IsRunningDedicatedServer() && !Character->WasRecentlyRendered(0.25f))
+	{
+		Distance *= Settings->OffscreenDistanceScale;
+	}
+
+	const int32 NewBucket = GetBucketForDistance(Distance);
+	if (CurrentBucket == INDEX_NONE || NewBucket == CurrentBucket)
+	{
+		return NewBucket;
+	}
+
+	// Stay in the current bucket until the distance is clearly past the crossed border
+	const float Border = Settings->Buckets[FMath::Min(NewBucket, CurrentBucket)].MaxDistance;
+	return FMath::Abs(Distance - Border) < Settings->HysteresisDistance ? CurrentBucket : NewBucket;
+}
+
+int32 UNPCLODSubsystem::GetBucketForDistance(const float Distance) const
+{
+	for (int32 Bucket = 0; Bucket < Settings->Buckets.Num(); ++Bucket)
+	{
+		if (Distance <= Settings->Buckets[Bucket].MaxDistance)
+		{
+			return Bucket;
+		}
+	}
+
+	return Settings->Buckets.Num() - 1;
+}
+
+void UNPCLODSubsystem::ApplyBucket(ANPCCharacterBase* Character, const int32 Bucket) const
+{
+	const FNPCLODBucket LOD = Settings && Settings->Buckets.IsValidIndex(Bucket) ? Settings->Buckets[Bucket] : FNPCLODBucket();
+
+	Character->SetActorTickInterval(LOD.ActorTickInterval);
+
+	if (UCharacterMovementComponent* Movement = Character->GetCharacterMovement())
+	{
+		Movement->SetComponentTickInterval(LOD.MovementTickInterval);
+	}
+
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		Mesh->SetComponentTickInterval(LOD.AnimationTickInterval);
+		// A dedicated server keeps the montage only option of the montage dispatcher, the notifies drive the damage
+		if (!IsRunningDedicatedServer())
+		{
+			Mesh->VisibilityBasedAnimTickOption = LOD.AnimTickOption;
+		}
+	}
+
+	AAIController* Controller = Cast<AAIController>(Character->GetController());
+	if (!Controller)
+	{
+		return;
+	}
+
+	Controller->SetActorTickInterval(LOD.ActorTickInterval);
+
+	if (UNPCBehaviorTreeComponent* BehaviorTree = Cast<UNPCBehaviorTreeComponent>(Controller->GetBrainComponent()))
+	{
+		BehaviorTree->SetMinTickInterval(LOD.BehaviorTreeTickInterval);
+	}
+
+	if (UAIPerceptionComponent* Perception = Controller->GetPerceptionComponent())
+	{
+		Perception->SetSenseEnabled(UAISense_Sight::StaticClass(), LOD.bEnableSight);
+	}
+
+	if (ANPCAIController* NPCController = Cast<ANPCAIController>(Controller))
+	{
+		NPCController->SetPerceptionUpdateInterval(LOD.PerceptionUpdateInterval);
+	}
+}
+
+void UNPCLODSubsystem::DumpStats() const
+{
+	const int32 NumBuckets = Settings ? Settings->Buckets.Num() : 0;
+
+	TArray<int32, TInlineAllocator<8>> NumPerBucket;
+	NumPerBucket.SetNumZeroed(NumBuckets);
+	int32 NumUnevaluated = 0;
+
+	for (const FNPCLODEntry& Entry : NPCs)
+	{
+		if (NumPerBucket.IsValidIndex(Entry.Bucket))
+		{
+			++NumPerBucket[Entry.Bucket];
+		}
+		else
+		{
+			++NumUnevaluated;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("NPC LOD: %d NPCs, %d not evaluated yet"), NPCs.Num(), NumUnevaluated);
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  Bucket %d (<= %.0f): %d"), Bucket, Settings->Buckets[Bucket].MaxDistance, NumPerBucket[Bucket]);
+	}
+}
@@ -0,0 +1,166 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCPoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "NPC/NPCCharacterBase.h"
+
+static TAutoConsoleVariable<int32> CVarNPCPoolMaxPerClass(
+	TEXT("Raider.AI.NPCPoolMaxPerClass"),
+	64,
+	TEXT("Maximum number of parked NPCs kept per NPC class. Released NPCs above it are destroyed."));
+
+static FAutoConsoleCommandWithWorld CmdDumpNPCPoolStats(
+	TEXT("Raider.AI.DumpNPCPoolStats"),
+	TEXT("Prints the NPC pool counters and high-water marks of every NPC class."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UNPCPoolSubsystem* NPCPool = World ? World->GetSubsystem<UNPCPoolSubsystem>() : nullptr)
+		{
+			NPCPool->DumpStats();
+		}
+	}));
+
+void UNPCPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	ResetStats();
+}
+
+void UNPCPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+ANPCCharacterBase* UNPCPoolSubsystem::AcquireNPC(const TSubclassOf<ANPCCharacterBase> NPCClass, const FTransform& SpawnTransform)
+{
+	if (!NPCClass)
+	{
+		return nullptr;
+	}
+
+	FNPCPool& Pool = Pools.FindOrAdd(NPCClass);
+	while (Pool.Parked.Num() > 0)
+	{
+		ANPCCharacterBase* Character = Pool.Parked.Pop(EAllowShrinking::No).Get();
+		if (!IsValid(Character))
+		{
+			continue;
+		}
+
+		Character->ActivateFromPool(SpawnTransform);
+		++Pool.Stats.NumReused;
+		MarkActive(Pool);
+		return Character;
+	}
+
+	ANPCCharacterBase* Character = GetWorld()->SpawnActor<ANPCCharacterBase>(NPCClass, SpawnTransform);
+	if (Character)
+	{
+		++Pool.Stats.NumSpawned;
+		MarkActive(Pool);
+	}
+	return Character;
+}
+
+void UNPCPoolSubsystem::ReleaseNPC(ANPCCharacterBase* Character)
+{
+	if (!IsValid(Character) || Character->IsPooled())
+	{
+		return;
+	}
+
+	// NPCs placed in the level were never handed out, but are pooled all the same
+	FNPCPool& Pool = Pools.FindOrAdd(Character->GetClass());
+	Pool.Stats.NumActive = FMath::Max(Pool.Stats.NumActive - 1, 0);
+
+	if (Pool.Parked.Num() >= CVarNPCPoolMaxPerClass.GetValueOnGameThread())
+	{
+		Character->Destroy();
+		++Pool.Stats.NumDestroyed;
+		return;
+	}
+
+	Character->DeactivateForPool();
+
+	Pool.Parked.Add(Character);
+	++Pool.Stats.NumReleased;
+	Pool.Stats.PeakPooled = FMath::Max(Pool.Stats.PeakPooled, Pool.Parked.Num());
+}
+
+int32 UNPCPoolSubsystem::Prewarm(const TSubclassOf<ANPCCharacterBase> NPCClass, const int32 Count)
+{
+	if (!NPCClass)
+	{
+		return 0;
+	}
+
+	FNPCPool& Pool = Pools.FindOrAdd(NPCClass);
+	const int32 NumWanted = FMath::Min(Count, CVarNPCPoolMaxPerClass.GetValueOnGameThread());
+
+	// Parked NPCs are hidden without collision, so they can all wait at the world origin
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	int32 NumSpawned = 0;
+	while (Pool.Parked.Num() < NumWanted)
+	{
+		ANPCCharacterBase* Character = GetWorld()->SpawnActor<ANPCCharacterBase>(NPCClass, FTransform::Identity, SpawnParameters);
+		if (!Character)
+		{
+			break;
+		}
+
+		Character->DeactivateForPool();
+		Pool.Parked.Add(Character);
+		++NumSpawned;
+	}
+
+	Pool.Stats.NumSpawned += NumSpawned;
+	Pool.Stats.PeakPooled = FMath::Max(Pool.Stats.PeakPooled, Pool.Parked.Num());
+	return NumSpawned;
+}
+
+const FNPCPoolStats* UNPCPoolSubsystem::GetStats(const TSubclassOf<ANPCCharacterBase> NPCClass) const
+{
+	const FNPCPool* Pool = Pools.Find(NPCClass);
+	return Pool ? &Pool->Stats : nullptr;
+}
+
+void UNPCPoolSubsystem::MarkActive(FNPCPool& Pool)
+{
+	++Pool.Stats.NumActive;
+	Pool.Stats.PeakActive = FMath::Max(Pool.Stats.PeakActive, Pool.Stats.NumActive);
+}
+
+void UNPCPoolSubsystem::DumpStats() const
+{
+	const double Minutes = FMath::Max((GetWorld()->GetTimeSeconds() - StatsStartTime) / 60.0, UE_KINDA_SMALL_NUMBER);
+
+	UE_LOG(LogTemp, Display, TEXT("NPC pool: %d classes"), Pools.Num());
+	for (const TPair<TSubclassOf<ANPCCharacterBase>, FNPCPool>& Pool : Pools)
+	{
+		const FNPCPoolStats& Stats = Pool.Value.Stats;
+		UE_LOG(LogTemp, Display, TEXT("  %s: %d active (peak %d), %d pooled (peak %d), %d spawned (%.1f/min), %d reused (%.1f/min), %d released, %d destroyed"),
+		       *GetNameSafe(Pool.Key), Stats.NumActive, Stats.PeakActive, Pool.Value.Parked.Num(), Stats.PeakPooled,
+		       Stats.NumSpawned, Stats.NumSpawned / Minutes, Stats.NumReused, Stats.NumReused / Minutes, Stats.NumReleased, Stats.NumDestroyed);
+	}
+}
+
+void UNPCPoolSubsystem::ResetStats()
+{
+	for (TPair<TSubclassOf<ANPCCharacterBase>, FNPCPool>& Pool : Pools)
+	{
+		const int32 NumActive = Pool.Value.Stats.NumActive;
+		Pool.Value.Stats = FNPCPoolStats();
+		Pool.Value.Stats.NumActive = NumActive;
+		Pool.Value.Stats.PeakActive = NumActive;
+		Pool.Value.Stats.PeakPooled = Pool.Value.Parked.Num();
+	}
+
+	StatsStartTime = GetWorld()->GetTimeSeconds();
+}
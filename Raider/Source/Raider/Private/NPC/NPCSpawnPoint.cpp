@@ -0,0 +1,47 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCSpawnPoint.h"
+
+#include "Components/ArrowComponent.h"
+#include "NPC/NPCSpawnPointSubsystem.h"
+
+ANPCSpawnPoint::ANPCSpawnPoint()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+#if WITH_EDITORONLY_DATA
+	ArrowComponent = CreateEditorOnlyDefaultSubobject<UArrowComponent>(TEXT("Arrow"));
+	if (ArrowComponent)
+	{
+		ArrowComponent->SetupAttachment(RootComponent);
+	}
+#endif
+}
+
+void ANPCSpawnPoint::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Registered before any BeginPlay, so the game mode finds the spawn points of loaded levels when it starts
+	UWorld* World = GetWorld();
+	if (World && World->IsGameWorld())
+	{
+		if (UNPCSpawnPointSubsystem* SpawnPoints = World->GetSubsystem<UNPCSpawnPointSubsystem>())
+		{
+			SpawnPoints->RegisterSpawnPoint(this);
+		}
+	}
+}
+
+void ANPCSpawnPoint::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UNPCSpawnPointSubsystem* SpawnPoints = GetWorld()->GetSubsystem<UNPCSpawnPointSubsystem>())
+	{
+		SpawnPoints->UnregisterSpawnPoint(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
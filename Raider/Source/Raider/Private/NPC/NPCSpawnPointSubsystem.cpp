@@ -0,0 +1,362 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCSpawnPointSubsystem.h"
+
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "NPC/NPCSpawnPoint.h"
+#include "NPC/Structs/FNPCPlayerView.h"
+
+static TAutoConsoleVariable<float> CVarSpawnPointCellSize(
+	TEXT("Raider.AI.SpawnPointCellSize"),
+	2000.0f,
+	TEXT("Edge length of a spawn point registry grid cell. Read when the world starts."));
+
+void UNPCSpawnPointSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CVarSpawnPointCellSize.GetValueOnGameThread(), 100.0f);
+}
+
+void UNPCSpawnPointSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	LevelAddedHandle.Reset();
+
+	SpawnPointSets.Empty();
+	TrackedClasses.Empty();
+
+	Super::Deinitialize();
+}
+
+void UNPCSpawnPointSubsystem::RegisterSpawnPoint(AActor* SpawnPoint)
+{
+	if (!SpawnPoint)
+	{
+		return;
+	}
+
+	FNPCSpawnPointSet& Set = SpawnPointSets.FindOrAdd(SpawnPoint->GetClass());
+	if (Set.EntryIndices.Contains(SpawnPoint))
+	{
+		return;
+	}
+
+	FNPCSpawnPointEntry Entry;
+	Entry.Actor = SpawnPoint;
+	Entry.ActorKey = SpawnPoint;
+	Entry.Location = SpawnPoint->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 EntryIndex = Set.Entries.Add(Entry);
+	Set.EntryIndices.Add(SpawnPoint, EntryIndex);
+	Set.Cells.FindOrAdd(Entry.Cell).Add(EntryIndex);
+	Set.MinCell = Set.MinCell.ComponentMin(Entry.Cell);
+	Set.MaxCell = Set.MaxCell.ComponentMax(Entry.Cell);
+}
+
+void UNPCSpawnPointSubsystem::UnregisterSpawnPoint(const AActor* SpawnPoint)
+{
+	FNPCSpawnPointSet* Set = SpawnPoint ? SpawnPointSets.Find(SpawnPoint->GetClass()) : nullptr;
+
+	int32 EntryIndex = INDEX_NONE;
+	if (!Set || !Set->EntryIndices.RemoveAndCopyValue(SpawnPoint, EntryIndex))
+	{
+		return;
+	}
+
+	const FIntPoint Cell = Set->Entries[EntryIndex].Cell;
+	if (TArray<int32>* CellEntries = Set->Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex);
+		if (CellEntries->Num() == 0)
+		{
+			Set->Cells.Remove(Cell);
+		}
+	}
+
+	// The last entry fills the gap, point its lookups at the new index
+	const int32 LastIndex = Set->Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		const FNPCSpawnPointEntry& LastEntry = Set->Entries[LastIndex];
+		if (TArray<int32>* CellEntries = Set->Cells.Find(LastEntry.Cell))
+		{
+			const int32 CellSlot = CellEntries->Find(LastIndex);
+			if (CellSlot != INDEX_NONE)
+			{
+				(*CellEntries)[CellSlot] = EntryIndex;
+			}
+		}
+		Set->EntryIndices.Add(LastEntry.ActorKey, EntryIndex);
+	}
+
+	Set->Entries.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+}
+
+void UNPCSpawnPointSubsystem::TrackSpawnPointClass(const TSubclassOf<AActor> SpawnPointClass)
+{
+	// Native spawn points register themselves
+	if (!SpawnPointClass || SpawnPointClass->IsChildOf<ANPCSpawnPoint>() || TrackedClasses.Contains(SpawnPointClass))
+	{
+		return;
+	}
+
+	TrackedClasses.Add(SpawnPointClass);
+	if (!LevelAddedHandle.IsValid())
+	{
+		LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UNPCSpawnPointSubsystem::OnLevelAdded);
+	}
+
+	// A single scan for the levels already loaded, streamed levels are handled as they are added
+	for (TActorIterator<AActor> Iterator(GetWorld(), SpawnPointClass); Iterator; ++Iterator)
+	{
+		RegisterTrackedSpawnPoint(*Iterator);
+	}
+}
+
+void UNPCSpawnPointSubsystem::RegisterTrackedSpawnPoint(AActor* SpawnPoint)
+{
+	if (IsValid(SpawnPoint))
+	{
+		RegisterSpawnPoint(SpawnPoint);
+		SpawnPoint->OnEndPlay.AddUniqueDynamic(this, &UNPCSpawnPointSubsystem::OnTrackedSpawnPointEndPlay);
+	}
+}
+
+void UNPCSpawnPointSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != GetWorld())
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor && TrackedClasses.ContainsByPredicate([Actor](const TSubclassOf<AActor>& TrackedClass) { return Actor->IsA(TrackedClass); }))
+		{
+			RegisterTrackedSpawnPoint(Actor);
+		}
+	}
+}
+
+void UNPCSpawnPointSubsystem::OnTrackedSpawnPointEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterSpawnPoint(Actor);
+}
+
+FIntPoint UNPCSpawnPointSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+template <typename VisitorType>
+void UNPCSpawnPointSubsystem::ForEachSet(const TSubclassOf<AActor> SpawnPointClass, VisitorType&& Visitor) const
+{
+	for (const TPair<TSubclassOf<AActor>, FNPCSpawnPointSet>& SpawnPointSet : SpawnPointSets)
+	{
+		if (SpawnPointSet.Key && (!SpawnPointClass || SpawnPointSet.Key->IsChildOf(SpawnPointClass)))
+		{
+			Visitor(SpawnPointSet.Value);
+		}
+	}
+}
+
+int32 UNPCSpawnPointSubsystem::GetSpawnPoints(const TSubclassOf<AActor> SpawnPointClass, TArray<AActor*>& OutSpawnPoints) const
+{
+	const int32 NumBefore = OutSpawnPoints.Num();
+
+	ForEachSet(SpawnPointClass, [&OutSpawnPoints](const FNPCSpawnPointSet& Set)
+	{
+		for (const FNPCSpawnPointEntry& Entry : Set.Entries)
+		{
+			if (AActor* SpawnPoint = Entry.Actor.Get())
+			{
+				OutSpawnPoints.Add(SpawnPoint);
+			}
+		}
+	});
+
+	return OutSpawnPoints.Num() - NumBefore;
+}
+
+AActor* UNPCSpawnPointSubsystem::GetRandomSpawnPoint(const TSubclassOf<AActor> SpawnPointClass) const
+{
+	int32 NumSpawnPoints = 0;
+	ForEachSet(SpawnPointClass, [&NumSpawnPoints](const FNPCSpawnPointSet& Set)
+	{
+		NumSpawnPoints += Set.Entries.Num();
+	});
+
+	if (NumSpawnPoints == 0)
+	{
+		return nullptr;
+	}
+
+	// Walk the sets to the one holding the picked index, usually there is only one
+	int32 RandomIndex = FMath::RandRange(0, NumSpawnPoints - 1);
+	AActor* SpawnPoint = nullptr;
+	ForEachSet(SpawnPointClass, [&RandomIndex, &SpawnPoint](const FNPCSpawnPointSet& Set)
+	{
+		if (RandomIndex >= 0 && RandomIndex < Set.Entries.Num())
+		{
+			SpawnPoint = Set.Entries[RandomIndex].Actor.Get();
+		}
+		RandomIndex -= Set.Entries.Num();
+	});
+
+	return SpawnPoint;
+}
+
+AActor* UNPCSpawnPointSubsystem::FindNearestSpawnPoint(const TSubclassOf<AActor> SpawnPointClass, const FVector& Location) const
+{
+	AActor* NearestSpawnPoint = nullptr;
+	double NearestDistanceSquared = UE_BIG_NUMBER;
+
+	ForEachSet(SpawnPointClass, [&](const FNPCSpawnPointSet& Set)
+	{
+		const FNPCSpawnPointEntry* Entry = FindNearestEntry(Set, Location);
+		const double DistanceSquared = Entry ? FVector::DistSquared(Entry->Location, Location) : UE_BIG_NUMBER;
+		if (Entry && DistanceSquared < NearestDistanceSquared)
+		{
+			NearestSpawnPoint = Entry->Actor.Get();
+			NearestDistanceSquared = DistanceSquared;
+		}
+	});
+
+	return NearestSpawnPoint;
+}
+
+const FNPCSpawnPointEntry* UNPCSpawnPointSubsystem::FindNearestEntry(const FNPCSpawnPointSet& Set, const FVector& Location) const
+{
+	if (Set.Entries.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	// Rings past this one hold no cell of the set
+	const FIntPoint Center = GetCell(Location);
+	const int32 MaxRing = FMath::Max(
+		FMath::Max(FMath::Abs(Center.X - Set.MinCell.X), FMath::Abs(Center.X - Set.MaxCell.X)),
+		FMath::Max(FMath::Abs(Center.Y - Set.MinCell.Y), FMath::Abs(Center.Y - Set.MaxCell.Y)));
+
+	const FNPCSpawnPointEntry* NearestEntry = nullptr;
+	double NearestDistanceSquared = UE_BIG_NUMBER;
+
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+	{
+		// Every cell of this ring is at least Ring - 1 cells away, nothing in it can be closer
+		if (NearestEntry && FMath::Square((Ring - 1) * static_cast<double>(CellSize)) > NearestDistanceSquared)
+		{
+			break;
+		}
+
+		for (int32 CellX = Center.X - Ring; CellX <= Center.X + Ring; ++CellX)
+		{
+			// Inner cells of the ring were visited by the previous rings, only walk its border
+			const bool bBorderColumn = CellX == Center.X - Ring || CellX == Center.X + Ring;
+			const int32 StepY = bBorderColumn ? 1 : 2 * Ring;
+
+			for (int32 CellY = Center.Y - Ring; CellY <= Center.Y + Ring; CellY += StepY)
+			{
+				const TArray<int32>* CellEntries = Set.Cells.Find(FIntPoint(CellX, CellY));
+				if (!CellEntries)
+				{
+					continue;
+				}
+
+				for (const int32 EntryIndex : *CellEntries)
+				{
+					const FNPCSpawnPointEntry& Entry = Set.Entries[EntryIndex];
+					const double DistanceSquared = FVector::DistSquared(Entry.Location, Location);
+					if (DistanceSquared < NearestDistanceSquared && Entry.Actor.IsValid())
+					{
+						NearestEntry = &Entry;
+						NearestDistanceSquared = DistanceSquared;
+					}
+				}
+			}
+		}
+	}
+
+	return NearestEntry;
+}
+
+int32 UNPCSpawnPointSubsystem::QuerySpawnPoints(const TSubclassOf<AActor> SpawnPointClass, const FVector& Origin, const float MinDistance,
+                                                const float MaxDistance, const bool bExcludeInView, TArray<AActor*>& OutSpawnPoints) const
+{
+	const int32 NumBefore = OutSpawnPoints.Num();
+
+	TArray<FNPCPlayerView, TInlineAllocator<4>> Views;
+	if (bExcludeInView)
+	{
+		FNPCPlayerView::GatherPlayerViews(GetWorld(), Views);
+	}
+
+	const double MinDistanceSquared = FMath::Square(static_cast<double>(MinDistance));
+	const double MaxDistanceSquared = FMath::Square(static_cast<double>(MaxDistance));
+
+	auto VisitEntry = [&](const FNPCSpawnPointEntry& Entry)
+	{
+		const double DistanceSquared = FVector::DistSquared(Entry.Location, Origin);
+		if (DistanceSquared < MinDistanceSquared || (MaxDistance > 0.0f && DistanceSquared > MaxDistanceSquared))
+		{
+			return;
+		}
+
+		if (Views.ContainsByPredicate([&Entry](const FNPCPlayerView& View) { return View.IsInView(Entry.Location); }))
+		{
+			return;
+		}
+
+		if (AActor* SpawnPoint = Entry.Actor.Get())
+		{
+			OutSpawnPoints.Add(SpawnPoint);
+		}
+	};
+
+	ForEachSet(SpawnPointClass, [&](const FNPCSpawnPointSet& Set)
+	{
+		if (MaxDistance <= 0.0f)
+		{
+			for (const FNPCSpawnPointEntry& Entry : Set.Entries)
+			{
+				VisitEntry(Entry);
+			}
+			return;
+		}
+
+		// Only the cells overlapping the bounds of the band
+		const FIntPoint MinCell = GetCell(Origin - FVector(MaxDistance));
+		const FIntPoint MaxCell = GetCell(Origin + FVector(MaxDistance));
+
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+			{
+				if (const TArray<int32>* CellEntries = Set.Cells.Find(FIntPoint(CellX, CellY)))
+				{
+					for (const int32 EntryIndex : *CellEntries)
+					{
+						VisitEntry(Set.Entries[EntryIndex]);
+					}
+				}
+			}
+		}
+	});
+
+	return OutSpawnPoints.Num() - NumBefore;
+}
+
+int32 UNPCSpawnPointSubsystem::GetNumSpawnPoints() const
+{
+	int32 NumSpawnPoints = 0;
+	for (const TPair<TSubclassOf<AActor>, FNPCSpawnPointSet>& SpawnPointSet : SpawnPointSets)
+	{
+		NumSpawnPoints += SpawnPointSet.Value.Entries.Num();
+	}
+	return NumSpawnPoints;
+}
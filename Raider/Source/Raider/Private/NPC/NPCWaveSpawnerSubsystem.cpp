@@ -0,0 +1,164 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "NPC/NPCWaveSpawnerSubsystem.h"
+
+#include "Engine/World.h"
+#include "NPC/NPCCharacterBase.h"
+#include "NPC/NPCLODSettings.h"
+#include "NPC/NPCPoolSubsystem.h"
+
+static TAutoConsoleVariable<float> CVarSpawnBudgetMs(
+	TEXT("Raider.AI.SpawnBudgetMs"),
+	2.0f,
+	TEXT("Milliseconds per frame the wave spawner may spend spawning enemies, at least one enemy is spawned per frame. 0 disables the limit."));
+
+static TAutoConsoleVariable<int32> CVarSpawnBudgetCount(
+	TEXT("Raider.AI.SpawnBudgetCount"),
+	4,
+	TEXT("Maximum number of enemies the wave spawner spawns per frame. 0 disables the limit."));
+
+void UNPCWaveSpawnerSubsystem::Deinitialize()
+{
+	PendingRequests.Empty();
+	Waves.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UNPCWaveSpawnerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNPCWaveSpawnerSubsystem, STATGROUP_Tickables);
+}
+
+int32 UNPCWaveSpawnerSubsystem::QueueWave(const TSubclassOf<AActor> EnemyClass, const TConstArrayView<FTransform> SpawnTransforms)
+{
+	if (!EnemyClass || SpawnTransforms.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 WaveId = NextWaveId++;
+	FNPCWave& Wave = Waves.Add(WaveId);
+	Wave.NumPending = SpawnTransforms.Num();
+	Wave.StartTime = GetWorld()->GetTimeSeconds();
+	Wave.StartFrame = GFrameCounter;
+
+	PendingRequests.Reserve(PendingRequests.Num() + SpawnTransforms.Num());
+	for (const FTransform& SpawnTransform : SpawnTransforms)
+	{
+		FNPCSpawnRequest& Request = PendingRequests.AddDefaulted_GetRef();
+		Request.EnemyClass = EnemyClass;
+		Request.SpawnTransform = SpawnTransform;
+		Request.WaveId = WaveId;
+	}
+
+	return WaveId;
+}
+
+void UNPCWaveSpawnerSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingRequests.Num() == 0)
+	{
+		return;
+	}
+
+	PrioritizeRequests();
+
+	const double BudgetSeconds = CVarSpawnBudgetMs.GetValueOnGameThread() / 1000.0;
+	const int32 BudgetCount = CVarSpawnBudgetCount.GetValueOnGameThread();
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Waves are reported after the queue is trimmed, listeners may queue the next wave
+	TArray<TPair<int32, int32>, TInlineAllocator<4>> FinishedWaves;
+
+	int32 NumProcessed = 0;
+	while (NumProcessed < PendingRequests.Num())
+	{
+		// Always make progress, even when a single spawn takes longer than the whole budget
+		if (NumProcessed > 0 &&
+			((BudgetCount > 0 && NumProcessed >= BudgetCount) ||
+			 (BudgetSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds)))
+		{
+			break;
+		}
+
+		// Copied, spawning runs BeginPlay which may queue more requests
+		const FNPCSpawnRequest Request = PendingRequests[NumProcessed++];
+		const bool bSpawned = SpawnEnemy(Request) != nullptr;
+
+		FNPCWave* Wave = Waves.Find(Request.WaveId);
+		if (!Wave)
+		{
+			continue;
+		}
+
+		Wave->NumSpawned += bSpawned ? 1 : 0;
+		if (--Wave->NumPending == 0)
+		{
+			UE_LOG(LogTemp, Log, TEXT("Wave %d finished: %d enemies spawned over %llu frames, %.2f s"), Request.WaveId,
+			       Wave->NumSpawned, GFrameCounter - Wave->StartFrame + 1, GetWorld()->GetTimeSeconds() - Wave->StartTime);
+
+			FinishedWaves.Emplace(Request.WaveId, Wave->NumSpawned);
+			Waves.Remove(Request.WaveId);
+		}
+	}
+
+	PendingRequests.RemoveAt(0, NumProcessed, EAllowShrinking::No);
+
+	for (const TPair<int32, int32>& FinishedWave : FinishedWaves)
+	{
+		OnWaveFinished.Broadcast(FinishedWave.Key, FinishedWave.Value);
+	}
+}
+
+void UNPCWaveSpawnerSubsystem::PrioritizeRequests()
+{
+	// Players move while a wave spawns, so the order is refreshed every frame
+	FNPCPlayerView::GatherPlayerViews(GetWorld(), Views);
+
+	// Without player views the requests keep their queue order
+	if (Views.Num() == 0)
+	{
+		return;
+	}
+
+	// Spawns outside every view count as further away, by the same factor the NPC LOD uses
+	const float OffscreenScale = GetDefault<UNPCLODSettings>()->OffscreenDistanceScale;
+
+	for (FNPCSpawnRequest& Request : PendingRequests)
+	{
+		const FVector Location = Request.SpawnTransform.GetLocation();
+
+		Request.Priority = UE_BIG_NUMBER;
+		for (const FNPCPlayerView& View : Views)
+		{
+			const float Distance = FVector::Dist(Location, View.Location);
+			Request.Priority = FMath::Min(Request.Priority, View.IsInView(Location) ? Distance : Distance * OffscreenScale);
+		}
+	}
+
+	PendingRequests.StableSort([](const FNPCSpawnRequest& A, const FNPCSpawnRequest& B)
+	{
+		return A.Priority < B.Priority;
+	});
+}
+
+AActor* UNPCWaveSpawnerSubsystem::SpawnEnemy(const FNPCSpawnRequest& Request) const
+{
+	if (!Request.EnemyClass)
+	{
+		return nullptr;
+	}
+
+	// NPCs are recycled through the NPC pool, other enemy classes are spawned as is
+	UNPCPoolSubsystem* NPCPool = GetWorld()->GetSubsystem<UNPCPoolSubsystem>();
+	if (NPCPool && Request.EnemyClass->IsChildOf<ANPCCharacterBase>())
+	{
+		return NPCPool->AcquireNPC(*Request.EnemyClass, Request.SpawnTransform);
+	}
+
+	return GetWorld()->SpawnActor<AActor>(Request.EnemyClass, Request.SpawnTransform);
+}
@@ -0,0 +1 @@
+﻿#include "NPC/Structs/FNPCLODBucket.h"
@@ -0,0 +1,39 @@
+﻿#include "NPC/Structs/FNPCPlayerView.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+bool FNPCPlayerView::IsInView(const FVector& InLocation) const
+{
+	const FVector ToLocation = InLocation - Location;
+	const float Distance = ToLocation.Size();
+
+	return Distance <= UE_KINDA_SMALL_NUMBER || FVector::DotProduct(ToLocation / Distance, Direction) >= CosHalfFOV;
+}
+
+void FNPCPlayerView::GatherPlayerViews(const UWorld* World, TArray<FNPCPlayerView, TInlineAllocator<4>>& OutViews)
+{
+	OutViews.Reset();
+	if (!World)
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		if (const APlayerController* PlayerController = Iterator->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			const float FOV = PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.0f;
+
+			FNPCPlayerView& View = OutViews.AddDefaulted_GetRef();
+			View.Location = ViewLocation;
+			View.Direction = ViewRotation.Vector();
+			View.CosHalfFOV = FMath::Cos(FMath::DegreesToRadians(FOV * 0.5f));
+		}
+	}
+}
@@ -1,9 +1,24 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Raider.h"
+#include "RaiderReplicationGraph.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Raider, "Raider" );
+class FRaiderModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Game net drivers replicate through the Raider replication graph, see Raider.Net.UseReplicationGraph
+		UReplicationDriver::CreateReplicationDriverDelegate().BindStatic(&URaiderReplicationGraph::CreateForNetDriver);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FRaiderModule, Raider, "Raider" );
 
 DEFINE_LOG_CATEGORY(LogRaider)
- 
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "RaiderCharacter.h"
 
 #include "RaiderPlayerController.h"
+#include "Animation/AnimMontage.h"
 #include "Blueprint/UserWidget.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Camera/CameraComponent.h"
@@ -18,6 +19,7 @@
 #include "../CombatSystem/Public/Components/MyComboAttackComponent.h"
 #include "../CombatSystem/Public/Components/MyHealthComponent.h"
 #include "../CombatSystem/Public/Components/MySpinAttackComponent.h"
+#include "../CombatSystem/Public/Components/MyMontageDispatcherComponent.h"
 
 ARaiderCharacter::ARaiderCharacter()
 	: TeamNumber(255),
@@ -65,6 +67,9 @@ ARaiderCharacter::ARaiderCharacter()
 	
 	// Spin Attack Component
 	SpinAttackComponent = CreateDefaultSubobject<UMySpinAttackComponent>("SpinAttackComponent");
+
+	// Montage Dispatcher Component
+	MontageDispatcherComponent = CreateDefaultSubobject<UMyMontageDispatcherComponent>("MontageDispatcherComponent");
 	
 }
 
@@ -156,9 +161,9 @@ void ARaiderCharacter::OnDeathHandler_Implementation()
 	//Play death animation
 	if (HealthComponent)
 	{
-		if (HealthComponent->DeathMontage)
+		if (UAnimMontage* DeathMontage = IMyPreloadInterface::ResolveAsset(HealthComponent->DeathMontage))
 		{
-			HealthComponent->PlayDeathMontage(HealthComponent->DeathMontage);
+			HealthComponent->PlayDeathMontage(DeathMontage);
 		}
 		else
 		{
@@ -212,8 +217,8 @@ void ARaiderCharacter::BeginPlay()
 		HealthComponent->OnDeath.AddDynamic(this, &ARaiderCharacter::OnDeathHandler);
 	}
 	
-	// Add Player UI
-	if (PlayerUIClass)
+	// Add Player UI, a dedicated server has no viewport
+	if (PlayerUIClass && !IsRunningDedicatedServer())
 	{
 		AddWidgetToViewPort(PlayerUIClass, false);
 	}
@@ -3,8 +3,14 @@
 #include "RaiderGameMode.h"
 #include "RaiderPlayerController.h"
 #include "RaiderCharacter.h"
+#include "Benchmark/RaiderBenchmarkSubsystem.h"
 #include "EntitySystem/MovieSceneEntitySystemRunner.h"
-#include "Kismet/GameplayStatics.h"
+#include "Interfaces/MyPreloadInterface.h"
+#include "NPC/NPCCharacterBase.h"
+#include "NPC/NPCPoolSubsystem.h"
+#include "NPC/NPCSpawnPointSubsystem.h"
+#include "NPC/NPCWaveSpawnerSubsystem.h"
+#include "Subsystems/MyAssetPreloadSubsystem.h"
 #include "UObject/ConstructorHelpers.h"
 
 ARaiderGameMode::ARaiderGameMode()
@@ -31,12 +37,52 @@ void ARaiderGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (UNPCWaveSpawnerSubsystem* WaveSpawner = GetWorld()->GetSubsystem<UNPCWaveSpawnerSubsystem>())
+	{
+		WaveSpawner->OnWaveFinished.AddDynamic(this, &ARaiderGameMode::OnEnemyWaveFinished);
+	}
+
+	// Stream the pooled NPC classes with their montages, weapons and behavior trees before constructing them
+	TArray<TSoftClassPtr<AActor>> PrewarmClasses;
+	for (const TPair<TSoftClassPtr<ANPCCharacterBase>, int32>& PrewarmCount : NPCPoolPrewarmCounts)
+	{
+		PrewarmClasses.Add(PrewarmCount.Key);
+	}
+
+	if (UMyAssetPreloadSubsystem* AssetPreload = GetWorld()->GetSubsystem<UMyAssetPreloadSubsystem>())
+	{
+		AssetPreload->PreloadClasses(PrewarmClasses, FOnAssetPreloadComplete::CreateUObject(this, &ARaiderGameMode::OnNPCPoolPreloaded));
+	}
+	else
+	{
+		OnNPCPoolPreloaded(0.0);
+	}
+}
+
+void ARaiderGameMode::OnNPCPoolPreloaded(const double LoadSeconds)
+{
+	// Construct the pooled NPCs up front instead of during the waves
+	if (UNPCPoolSubsystem* NPCPool = GetWorld()->GetSubsystem<UNPCPoolSubsystem>())
+	{
+		for (const TPair<TSoftClassPtr<ANPCCharacterBase>, int32>& PrewarmCount : NPCPoolPrewarmCounts)
+		{
+			NPCPool->Prewarm(PrewarmCount.Key.Get(), PrewarmCount.Value);
+		}
+	}
+
+	// The benchmark spawns its own enemies around the player
+	if (URaiderBenchmarkSubsystem* Benchmark = GetWorld()->GetSubsystem<URaiderBenchmarkSubsystem>())
+	{
+		Benchmark->StartBenchmark(*this);
+		return;
+	}
+
 	StartEnemySpawn(EnemyClass, NPCSpawnPointClass);
 }
 
-void ARaiderGameMode::StartEnemySpawn(const TSubclassOf<AActor>& InEnemyClass, const TSubclassOf<AActor>& InSpawnPointClass) const
+void ARaiderGameMode::StartEnemySpawn(const TSoftClassPtr<AActor>& InEnemyClass, const TSubclassOf<AActor>& InSpawnPointClass)
 {
-	if (!InEnemyClass)
+	if (InEnemyClass.IsNull())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("InEnemyClass is NULL"));
 		return;
@@ -48,21 +94,64 @@ void ARaiderGameMode::StartEnemySpawn(const TSubclassOf<AActor>& InEnemyClass, c
 		return;
 	}
 	
-	// Spawn enemy at each NPC spawn points in the level
+	// Queue an enemy at each NPC spawn points in the level
 	TArray<AActor*> SpawnPoints;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), InSpawnPointClass, SpawnPoints);
+	if (UNPCSpawnPointSubsystem* SpawnPointRegistry = GetWorld()->GetSubsystem<UNPCSpawnPointSubsystem>())
+	{
+		// Spawn points which are not ANPCSpawnPoint actors don't register themselves, their class is scanned once
+		SpawnPointRegistry->TrackSpawnPointClass(InSpawnPointClass);
+		SpawnPointRegistry->GetSpawnPoints(InSpawnPointClass, SpawnPoints);
+	}
 
-	if (SpawnPoints.Num() > 0)
+	if (SpawnPoints.Num() == 0)
 	{
-		for (int i = 0; i < SpawnPoints.Num(); i++)
-		{
-			FTransform SpawnPoint = SpawnPoints[i]->GetTransform();
-			SpawnEnemy(InEnemyClass, SpawnPoint);
-		}
+		UE_LOG(LogTemp, Warning, TEXT("No NPC Spawn Points Found"));
+		return;
+	}
+
+	TArray<FTransform> SpawnTransforms;
+	SpawnTransforms.Reserve(SpawnPoints.Num());
+	for (const AActor* SpawnPoint : SpawnPoints)
+	{
+		SpawnTransforms.Add(SpawnPoint->GetTransform());
+	}
+
+	StartEnemySpawnAt(InEnemyClass, SpawnTransforms);
+}
+
+void ARaiderGameMode::StartEnemySpawnAt(const TSoftClassPtr<AActor>& InEnemyClass, const TArray<FTransform>& SpawnTransforms)
+{
+	if (InEnemyClass.IsNull() || SpawnTransforms.Num() == 0)
+	{
+		return;
+	}
+
+	// The wave is queued once the enemy class and everything it plays or spawns is loaded, right away when it already is
+	if (UMyAssetPreloadSubsystem* AssetPreload = GetWorld()->GetSubsystem<UMyAssetPreloadSubsystem>())
+	{
+		AssetPreload->PreloadClasses(MakeArrayView(&InEnemyClass, 1),
+		                             FOnAssetPreloadComplete::CreateUObject(this, &ARaiderGameMode::OnEnemyWavePreloaded, InEnemyClass, SpawnTransforms));
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("No NPC Spawn Points Found"));
+		OnEnemyWavePreloaded(0.0, InEnemyClass, SpawnTransforms);
+	}
+}
+
+void ARaiderGameMode::OnEnemyWavePreloaded(const double LoadSeconds, const TSoftClassPtr<AActor> InEnemyClass, const TArray<FTransform> SpawnTransforms)
+{
+	UE_LOG(LogTemp, Display, TEXT("Enemy wave of %s preloaded in %.1f ms"), *InEnemyClass.ToString(), LoadSeconds * 1000.0);
+
+	const TSubclassOf<AActor> LoadedEnemyClass = IMyPreloadInterface::ResolveClass(InEnemyClass);
+	if (!LoadedEnemyClass)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("InEnemyClass failed to load"));
+		return;
+	}
+
+	if (UNPCWaveSpawnerSubsystem* WaveSpawner = GetWorld()->GetSubsystem<UNPCWaveSpawnerSubsystem>())
+	{
+		WaveSpawner->QueueWave(LoadedEnemyClass, SpawnTransforms);
 	}
 }
 
@@ -73,26 +162,16 @@ FTransform ARaiderGameMode::GetRandomSpawnPoints(const TSubclassOf<AActor>& InSp
 		return FTransform();
 	}
 
-	TArray<AActor*> SpawnPoints;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), InSpawnPointClass, SpawnPoints);
-
-	if (SpawnPoints.Num() > 0)
+	const UNPCSpawnPointSubsystem* SpawnPointRegistry = GetWorld()->GetSubsystem<UNPCSpawnPointSubsystem>();
+	if (const AActor* SpawnPoint = SpawnPointRegistry ? SpawnPointRegistry->GetRandomSpawnPoint(InSpawnPointClass) : nullptr)
 	{
-		int32 RandomIndex = FMath::RandRange(0, SpawnPoints.Num() - 1);
-		return SpawnPoints[RandomIndex]->GetTransform();
+		return SpawnPoint->GetTransform();
 	}
 	
 	return FTransform();
 }
 
-void ARaiderGameMode::SpawnEnemy(const TSubclassOf<AActor>& InEnemyClass, const FTransform& InSpawnPoint) const
+void ARaiderGameMode::OnEnemyWaveFinished(const int32 WaveId, const int32 NumSpawned)
 {
-	if (InEnemyClass)
-	{
-		GetWorld()->SpawnActor<AActor>(InEnemyClass, InSpawnPoint);
-	}
-	else
-	{
-		UE_LOG(LogTemp, Warning, TEXT("InEnemyClass is NULL"));
-	}
+	UE_LOG(LogTemp, Display, TEXT("Enemy wave %d spawned %d enemies"), WaveId, NumSpawned);
 }
@@ -186,7 +186,7 @@ void ARaiderPlayerController::StopLightAttack()
 {
 	if (ARaiderCharacter* MyCharacter = Cast<ARaiderCharacter>(GetPawn()))
 	{
-		MyCharacter->ComboAttackComponent->ResetCombo();
+		MyCharacter->ComboAttackComponent->ReleaseAttackInput(EComboInput::Light);
 	}
 }
 
@@ -194,8 +194,14 @@ void ARaiderPlayerController::StartHeavyAttack()
 {
 	if (ARaiderCharacter* MyCharacter = Cast<ARaiderCharacter>(GetPawn()))
 	{
+		// Heavy attacks continue a combo that branches on them, otherwise they start the spin
+		if (MyCharacter->ComboAttackComponent->HandleAttackInput(nullptr, EComboInput::Heavy))
+		{
+			return;
+		}
+
 		MyCharacter->SpinAttackComponent->StartSpinAttack();
-		MyCharacter->CombatComponent->bIsInvincible = true;
+		MyCharacter->CombatComponent->SetInvincible(true);
 	}
 }
 
@@ -203,8 +209,9 @@ void ARaiderPlayerController::StopHeavyAttack()
 {
 	if (ARaiderCharacter* MyCharacter = Cast<ARaiderCharacter>(GetPawn()))
 	{
+		MyCharacter->ComboAttackComponent->ReleaseAttackInput(EComboInput::Heavy);
 		MyCharacter->SpinAttackComponent->StopSpinAttack();
-		MyCharacter->CombatComponent->bIsInvincible = false;
+		MyCharacter->CombatComponent->SetInvincible(false);
 	}
 }
 
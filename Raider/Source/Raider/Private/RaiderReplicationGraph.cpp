@@ -0,0 +1,176 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "RaiderReplicationGraph.h"
+
+#include "RaiderCharacter.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "NPC/NPCCharacterBase.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<bool> CVarUseReplicationGraph(
+	TEXT("Raider.Net.UseReplicationGraph"),
+	true,
+	TEXT("Whether game net drivers use the Raider replication graph, read when a net driver starts. Set it with -dpcvars to compare against the default replication."));
+
+static TAutoConsoleVariable<float> CVarReplicationGridCellSize(
+	TEXT("Raider.Net.GridCellSize"),
+	10000.0f,
+	TEXT("Edge length of the cells of the replication grid, read when a net driver starts."));
+
+namespace RaiderReplicationGraph
+{
+	/** Moves the negative quadrants of the world into the grid, which starts at 0,0 */
+	constexpr float SpatialBias = -200000.0f;
+}
+
+UReplicationDriver* URaiderReplicationGraph::CreateForNetDriver(UNetDriver* ForNetDriver, const FURL& URL, UWorld* World)
+{
+	// Beacons and demo recordings keep the default replication
+	if (!CVarUseReplicationGraph.GetValueOnGameThread() || !ForNetDriver || ForNetDriver->NetDriverName != NAME_GameNetDriver)
+	{
+		return nullptr;
+	}
+
+	return NewObject<URaiderReplicationGraph>(GetTransientPackage());
+}
+
+ERaiderClassRepNodeMapping URaiderReplicationGraph::GetMappingPolicy(const UClass* Class) const
+{
+	const AActor* ActorCDO = Class ? Cast<AActor>(Class->GetDefaultObject()) : nullptr;
+	if (!ActorCDO || !ActorCDO->GetIsReplicated())
+	{
+		return ERaiderClassRepNodeMapping::NotRouted;
+	}
+
+	// NPCs are checked before the relevancy flags, a Blueprint could have set them by accident
+	if (Class->IsChildOf<ANPCCharacterBase>())
+	{
+		return ERaiderClassRepNodeMapping::Spatialize_Dormancy;
+	}
+
+	if (Class->IsChildOf<ARaiderCharacter>() || Class->IsChildOf<APlayerState>() || Class->IsChildOf<AGameStateBase>())
+	{
+		return ERaiderClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	// Player controllers and whatever else only its owner sees come from the connection node
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return ERaiderClassRepNodeMapping::NotRouted;
+	}
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return ERaiderClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	const USceneComponent* RootComponent = ActorCDO->GetRootComponent();
+	return RootComponent && RootComponent->Mobility != EComponentMobility::Movable
+		       ? ERaiderClassRepNodeMapping::Spatialize_Static
+		       : ERaiderClassRepNodeMapping::Spatialize_Dynamic;
+}
+
+void URaiderReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Blueprint classes loaded later, such as the enemies, fall back to their native parent
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if (!Class->IsChildOf<AActor>() || Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists) ||
+			Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		const ERaiderClassRepNodeMapping Policy = GetMappingPolicy(Class);
+		ClassRepNodePolicies.Set(Class, Policy);
+
+		// Cull distance and update frequency come from the default object, the grid culls spatialized actors by distance
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, Policy >= ERaiderClassRepNodeMapping::Spatialize_Static);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void URaiderReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = CVarReplicationGridCellSize.GetValueOnGameThread();
+	GridNode->SpatialBias = FVector2D(RaiderReplicationGraph::SpatialBias, RaiderReplicationGraph::SpatialBias);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void URaiderReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// Adds the player controller and the view target of the connection
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, ConnectionManager);
+}
+
+void URaiderReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const ERaiderClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+	switch (Policy ? *Policy : ERaiderClassRepNodeMapping::NotRouted)
+	{
+	case ERaiderClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void URaiderReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const ERaiderClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+	switch (Policy ? *Policy : ERaiderClassRepNodeMapping::NotRouted)
+	{
+	case ERaiderClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case ERaiderClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,16 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "RaiderStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(RaiderChannel);
+
+DEFINE_STAT(STAT_RaiderHitsQueried);
+DEFINE_STAT(STAT_RaiderHitsApplied);
+DEFINE_STAT(STAT_RaiderDamageEventsApplied);
+DEFINE_STAT(STAT_RaiderReactionsPlayed);
+
+DEFINE_STAT(STAT_RaiderPerceptionEvents);
+DEFINE_STAT(STAT_RaiderBlackboardWrites);
+DEFINE_STAT(STAT_RaiderTokenRequests);
+DEFINE_STAT(STAT_RaiderTokenGrants);
@@ -0,0 +1,119 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+
+#include "Components/MyCombatComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/AutomationTest.h"
+#include "NPC/NPCCharacterBase.h"
+#include "Structs/FSDamageInfo.h"
+#include "Subsystems/MyTeamRegistrySubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace RaiderDamageAllocationTest
+{
+	/** Number of enemies overlapping the attack */
+	constexpr int32 NumTargets = 64;
+
+	/**
+	 *  Counts the allocator calls made during its scope from the allocator's own call counters, the process allocator stays in place.
+	 *  The counters are process wide, so anything other threads allocate meanwhile is counted too.
+	 */
+	class FScopedMallocCounter
+	{
+	public:
+		FScopedMallocCounter()
+			: StartCalls(GetAllocationCalls())
+		{
+		}
+
+		/** Malloc and Realloc calls made since the counter was created */
+		uint64 GetNumAllocations() const
+		{
+			return GetAllocationCalls() - StartCalls;
+		}
+
+	private:
+		uint64 StartCalls;
+
+		static uint64 GetAllocationCalls()
+		{
+			return static_cast<uint64>(FMalloc::TotalMallocCalls) + static_cast<uint64>(FMalloc::TotalReallocCalls);
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRaiderDamageAllocationTest, "Raider.Combat.DamageAllNoneTeamMembers.NoAllocationPerHit",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FRaiderDamageAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace RaiderDamageAllocationTest;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// The hits go through the end of frame queue, which is what is measured
+	IConsoleVariable* DeferredDamage = IConsoleManager::Get().FindConsoleVariable(TEXT("Raider.Combat.DeferredDamage"));
+	const bool bWasDeferred = DeferredDamage && DeferredDamage->GetBool();
+	if (DeferredDamage)
+	{
+		DeferredDamage->Set(true, ECVF_SetByCode);
+	}
+
+	if (UMyTeamRegistrySubsystem* TeamRegistry = World->GetSubsystem<UMyTeamRegistrySubsystem>())
+	{
+		TeamRegistry->SetAttitude(0, 1, ETeamAttitude::Hostile);
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// The attacker is on team 0, the targets keep the default team 1
+	ANPCCharacterBase* Attacker = World->SpawnActorDeferred<ANPCCharacterBase>(ANPCCharacterBase::StaticClass(), FTransform::Identity, nullptr, nullptr,
+	                                                                           ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	Attacker->SetTeamNumber(0);
+	Attacker->FinishSpawning(FTransform::Identity);
+
+	TArray<AActor*> Targets;
+	for (int32 Index = 0; Index < NumTargets; ++Index)
+	{
+		const FVector Location(100.0f * FMath::Cos(UE_TWO_PI * Index / NumTargets), 100.0f * FMath::Sin(UE_TWO_PI * Index / NumTargets), 0.0f);
+		Targets.Add(World->SpawnActor<ANPCCharacterBase>(ANPCCharacterBase::StaticClass(), FTransform(Location), SpawnParameters));
+	}
+
+	const FSDamageInfo DamageInfo(20.0f, EDamageType::Melee, EDamageReact::Hit, false, false, true);
+
+	// The first hit sets up what is created once, such as stat and trace registration
+	FDamagedActorArray DamagedActors;
+	Attacker->CombatComponent->DamageAllNoneTeamMembers(MakeArrayView(Targets), DamageInfo, DamagedActors);
+	DamagedActors.Reset();
+
+	int32 NumDamaged;
+	uint64 NumAllocations;
+	{
+		const FScopedMallocCounter MallocCounter;
+		NumDamaged = Attacker->CombatComponent->DamageAllNoneTeamMembers(MakeArrayView(Targets), DamageInfo, DamagedActors);
+		NumAllocations = MallocCounter.GetNumAllocations();
+	}
+
+	TestEqual(TEXT("Every overlapping enemy is damaged"), NumDamaged, NumTargets);
+	TestEqual(TEXT("Heap allocations per hit event"), NumAllocations, static_cast<uint64>(0));
+
+	if (DeferredDamage)
+	{
+		DeferredDamage->Set(bWasDeferred, ECVF_SetByCode);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,21 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Running totals of the events the benchmark reports per second. Incremented on the game thread
+ *  wherever the event happens, the benchmark samples them and reports the difference.
+ */
+struct RAIDER_API FRaiderBenchmarkCounters
+{
+	/** Damage events queued in the damage pipeline */
+	static int64 NumDamageEvents;
+
+	/** Perception updates received by NPC controllers */
+	static int64 NumPerceptionUpdates;
+
+	/** Behavior tree component ticks */
+	static int64 NumBehaviorTreeTicks;
+};
@@ -0,0 +1,71 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "RaiderBenchmarkSettings.generated.h"
+
+/**
+ *  =====================================================
+ *  Project settings of the headless combat benchmark started with -RaiderBenchmark.
+ *  Every value can be overridden on the command line, see the README.
+ *  =====================================================
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Raider Benchmark"))
+class RAIDER_API URaiderBenchmarkSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	URaiderBenchmarkSettings();
+
+	virtual FName GetCategoryName() const override;
+
+	/** Enemy classes spawned in turn around the player */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark")
+	TArray<TSoftClassPtr<AActor>> EnemyClasses;
+
+	/** Number of enemies spawned, -BenchmarkEnemies= */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "1"))
+	int32 NumEnemies;
+
+	/** Simulated seconds before sampling starts, lets the wave spawn and the fight start, -BenchmarkWarmup= */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float WarmupSeconds;
+
+	/** Simulated seconds sampled, -BenchmarkDuration= */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "1.0"))
+	float DurationSeconds;
+
+	/** Simulated frames per second, every frame advances the same time so runs replay alike, -BenchmarkFPS= */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "1.0"))
+	float FixedFrameRate;
+
+	/** Simulated seconds covered by one CSV row */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "0.1"))
+	float SampleInterval;
+
+	/** Seed of the random streams, -BenchmarkSeed= */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark")
+	int32 Seed;
+
+	/** Enemies are spawned on a ring around the player between these distances */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float MinSpawnDistance;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float MaxSpawnDistance;
+
+	/** Distance the player looks for enemies at */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark|Player", meta = (ClampMin = "0.0"))
+	float PlayerSearchRadius;
+
+	/** Distance the player attacks from, further enemies are walked to */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark|Player", meta = (ClampMin = "0.0"))
+	float PlayerAttackRange;
+
+	/** Simulated seconds between two decisions of the player */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark|Player", meta = (ClampMin = "0.0"))
+	float PlayerThinkInterval;
+};
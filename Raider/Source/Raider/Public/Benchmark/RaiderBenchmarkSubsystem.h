@@ -0,0 +1,213 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RaiderBenchmarkSubsystem.generated.h"
+
+class ARaiderCharacter;
+class ARaiderGameMode;
+
+/** Totals of one CSV row */
+struct FRaiderBenchmarkSample
+{
+	/** Simulated seconds covered */
+	double Seconds = 0.0;
+
+	/** Frames covered */
+	int32 NumFrames = 0;
+
+	/** Sum and maximum of the wall clock frame times */
+	double FrameMsSum = 0.0;
+	double MaxFrameMs = 0.0;
+
+	/** Sum of the game thread times reported by the engine, idle and waits excluded */
+	double GameThreadMsSum = 0.0;
+
+	/** Sum of the times the net driver spent sending, replication included */
+	double NetTickMsSum = 0.0;
+
+	/** Events counted while the sample was taken */
+	int64 NumDamageEvents = 0;
+	int64 NumPerceptionUpdates = 0;
+	int64 NumBehaviorTreeTicks = 0;
+
+	/** Bytes the net driver sent and received while the sample was taken */
+	int64 NumBytesOut = 0;
+	int64 NumBytesIn = 0;
+
+	/** Sum of the active NPCs of every frame */
+	int64 ActiveNPCFrames = 0;
+};
+
+/**
+ *  =====================================================
+ *  Headless combat benchmark, only created when the game runs with -RaiderBenchmark.
+ *  The game mode hands over the first wave: enemies are spawned around the player, who
+ *  walks to and attacks the closest one on its own. A dedicated server spawns a stand-in player,
+ *  and -BenchmarkClients=N holds the start until N clients joined. Every frame advances the same simulated
+ *  time, and after the warmup one CSV row is written per sample interval with frame and game
+ *  thread times, damage events, perception updates and behavior tree ticks per second, the
+ *  number of combatants, memory, the net tick time and the bytes sent and received per second and per active NPC.
+ *  The last row sums up the run, then the game exits.
+ *  =====================================================
+ */
+UCLASS()
+class RAIDER_API URaiderBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Whether the game was started with -RaiderBenchmark */
+	static bool IsBenchmarkRequested();
+
+	/**
+	 *  Spawns the enemies around the first player through the game mode and starts the warmup.
+	 *  @param GameMode - The game mode queuing the waves
+	 */
+	void StartBenchmark(ARaiderGameMode& GameMode);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+/**
+ *	---------------------------------------------
+ *  Options, from the benchmark settings and the command line
+ *  ---------------------------------------------
+ */
+private:
+	TArray<TSoftClassPtr<AActor>> EnemyClasses;
+	int32 NumEnemies = 0;
+	float WarmupSeconds = 0.0f;
+	float DurationSeconds = 0.0f;
+	float FixedFrameRate = 0.0f;
+	float SampleInterval = 0.0f;
+	int32 Seed = 0;
+	int32 NumClients = 0;
+	FString CsvPath;
+
+	/** Reads the settings and their command line overrides */
+	void ReadOptions();
+
+/**
+ *	---------------------------------------------
+ *  Run
+ *  ---------------------------------------------
+ */
+private:
+	/** Game mode queuing the waves */
+	TWeakObjectPtr<ARaiderGameMode> GameModeRef;
+
+	/** The player driven by the benchmark */
+	TWeakObjectPtr<ARaiderCharacter> Player;
+
+	/** Random stream of the spawn locations */
+	FRandomStream RandomStream;
+
+	/** Whether the benchmark waits for NumClients clients to connect before it starts */
+	bool bIsWaitingForClients = false;
+
+	/** Whether the benchmark started and didn't finish yet */
+	bool bIsRunning = false;
+
+	/** World time the benchmark started at */
+	double StartTime = 0.0;
+
+	/** World time of the last player decision */
+	double LastThinkTime = 0.0;
+
+
+	/** Fixed time step in use before the benchmark started, restored afterwards */
+	bool bPreviousUseFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+
+	/** Number of clients connected to the net driver of the world */
+	int32 GetNumConnectedClients() const;
+
+	/** Spawns the default pawn at a player start with an AI controller, stands in for the player on a dedicated server */
+	ARaiderCharacter* SpawnStandInPlayer(ARaiderGameMode& GameMode) const;
+
+	/** Queues enemies of every class until each class has its share of NumEnemies active */
+	void TopUpEnemies();
+
+	/** Makes spawn transforms on a ring around the player, on the navigation mesh when possible */
+	void MakeSpawnTransforms(int32 Count, TArray<FTransform>& OutTransforms);
+
+	/** Walks the player to the closest enemy and attacks once in range */
+	void DrivePlayer();
+
+/**
+ *	---------------------------------------------
+ *  Samples
+ *  ---------------------------------------------
+ */
+private:
+	/** Whether the warmup is over */
+	bool bIsSampling = false;
+
+	/** Platform time the current and the previous frame started at */
+	double FrameStartTime = 0.0;
+	double LastFrameStartTime = 0.0;
+
+	/** Handles of the frame bindings */
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
+
+	/** Platform time the net driver started sending at, and the handles of the bindings timing it */
+	double NetTickStartTime = 0.0;
+	FDelegateHandle TickFlushHandle;
+	FDelegateHandle PostTickFlushHandle;
+
+	/** The row being taken */
+	FRaiderBenchmarkSample Sample;
+
+	/** Totals of every row */
+	FRaiderBenchmarkSample Total;
+
+	/** Event counters when the row started */
+	int64 SampleDamageEvents = 0;
+	int64 SamplePerceptionUpdates = 0;
+	int64 SampleBehaviorTreeTicks = 0;
+
+	/** Net driver byte totals when the row started */
+	uint32 SampleBytesOut = 0;
+	uint32 SampleBytesIn = 0;
+
+	/** Number of NPCs of the enemy classes in play */
+	int32 GetNumActiveNPCs() const;
+
+	/** Reads the byte totals of the net driver of the world, zero without one */
+	void GetNetBytes(uint32& OutBytesOut, uint32& OutBytesIn) const;
+
+	/** Lines of the CSV file */
+	TArray<FString> CsvLines;
+
+	/** Remembers when the frame started */
+	void OnBeginFrame();
+
+	/** Adds the frame to the row, ends the row once it covers the sample interval and the run once it is over */
+	void OnEndFrame();
+
+	/** Remember when the net driver starts sending and add the time it took to the row */
+	void OnTickFlush(float DeltaSeconds);
+	void OnPostTickFlush();
+
+	/** Starts a new row */
+	void BeginSample();
+
+	/** Adds the finished row to the CSV and the totals */
+	void EndSample();
+
+	/** Formats a row, Label is written in the time column */
+	FString FormatRow(const FString& Label, const FRaiderBenchmarkSample& Row) const;
+
+	/** Writes the CSV and exits the game */
+	void FinishBenchmark();
+};
@@ -0,0 +1,52 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTTask_RequestAttackToken.generated.h"
+
+/** Memory of a running request */
+struct FBTRequestAttackTokenMemory
+{
+	/** The target the controlled pawn waits for */
+	TWeakObjectPtr<AActor> Target;
+};
+
+/**
+ *  Requests attack tokens from the target in the blackboard.
+ *  Waits in the target's queue until the tokens are granted instead of polling every tick.
+ */
+UCLASS()
+class RAIDER_API UBTTask_RequestAttackToken : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+public:
+	UBTTask_RequestAttackToken();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual void InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const override;
+	virtual void CleanupMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryClear::Type CleanupType) const override;
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	/** Blackboard key holding the attack target */
+	UPROPERTY(EditAnywhere, Category = "Token")
+	FBlackboardKeySelector TargetKey;
+
+	/** The number of attack tokens to request */
+	UPROPERTY(EditAnywhere, Category = "Token", meta = (ClampMin = "1"))
+	int32 AttackTokenNeeded;
+
+	/** Position in the target's queue, higher priorities are served first */
+	UPROPERTY(EditAnywhere, Category = "Token")
+	int32 Priority;
+
+private:
+	/** Finishes the waiting task when the request is resolved */
+	void OnTokenResolved(bool bGranted, TWeakObjectPtr<UBehaviorTreeComponent> OwnerComp);
+};
@@ -4,16 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "AIController.h"
-#include "Enums/EAISense.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
 #include "Enums/EAIState.h"
+#include "Perception/AIPerceptionTypes.h"
 #include "NPCAIController.generated.h"
 
 class ANPCCharacterBase;
-struct FAIStimulus;
 class UAISenseConfig_Damage;
 class UAISenseConfig_Hearing;
 class UAISenseConfig_Sight;
 class UAIPerceptionComponent;
+class UMyTeamRegistrySubsystem;
 
 /**
  *  Initializes perception components for Sight, Hearing, and Damage.
@@ -27,6 +28,10 @@ class RAIDER_API ANPCAIController : public AAIController
 public:
 	ANPCAIController();
 
+	/** Moves keep the controlled NPC awake for replication, passive NPCs only go net dormant while they stand */
+	virtual FAIRequestID RequestMove(const FAIMoveRequest& MoveRequest, FNavPathSharedPtr Path) override;
+	virtual void OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result) override;
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -40,11 +45,11 @@ public:
 	
 	/** Sets AI state to Passive */
 	UFUNCTION(BlueprintCallable, Category = "NPC|AIState")
-	void SetStateAsPassive() const;
+	void SetStateAsPassive();
 
 	/** Sets AI state to Frozen */
 	UFUNCTION(BlueprintCallable, Category = "NPC|AIState")
-	void SetStateAsFrozen() const;
+	void SetStateAsFrozen();
 
 	/** Sets AI state to Attacking and assigns a target */
 	UFUNCTION(BlueprintCallable, Category = "NPC|AIState")
@@ -52,20 +57,34 @@ public:
 
 	/** Sets AI state to Investigating and updates the target location */
 	UFUNCTION(BlueprintCallable, Category = "NPC|AIState")
-	void SetStateAsInvestigating(const FVector Location) const;
+	void SetStateAsInvestigating(const FVector Location);
 
 	/** Sets AI state to Dead */
 	UFUNCTION(BlueprintCallable, Category = "NPC|AIState")
-	void SetStateAsDead() const;
+	void SetStateAsDead();
+
+	/** Investigated locations closer than this to the current one are not written again */
+	UPROPERTY(EditDefaultsOnly, Category = "NPC|AIState")
+	float InvestigateLocationTolerance = 100.0f;
+
+	/** Gets the current AI state */
+	UFUNCTION(BlueprintPure, Category = "NPC|AIState")
+	EAIState GetCurrentState() const { return CurrentState; }
+
+	/** Whether the AI state machine allows going from one state to another */
+	static bool IsLegalTransition(EAIState FromState, EAIState ToState);
+
+	/** Stops the behavior tree and perception while the controlled NPC is parked in the NPC pool */
+	void DeactivateForPool();
+
+	/** Starts the controlled NPC over from Passive with a cleared target and restarts the behavior tree and perception */
+	void ActivateFromPool();
 	
 protected:
 	/** Blackboard component to store blackboard instance we used */
 	UPROPERTY(EditAnywhere, Category = "NPC|BehaviorTree")
 	UBlackboardComponent* BlackboardComponent;
 
-	/** Gets the current AI state from the blackboard */
-	EAIState GetCurrentState() const;
-
 	/** Set combat range variables to the blackboard */
 	void SetCombatRange() const;
 
@@ -73,6 +92,40 @@ private:
 	/** The character who owns this AI controller */
 	UPROPERTY()
 	ANPCCharacterBase* OwnerCharacter;
+
+	/** Team registry of the world, cached at BeginPlay */
+	UPROPERTY()
+	TObjectPtr<UMyTeamRegistrySubsystem> TeamRegistry;
+
+	/** Native AI state, mirrored to the AIState blackboard key */
+	EAIState CurrentState;
+
+	/** Blackboard keys resolved when the blackboard is initialized */
+	FBlackboard::FKey AIStateKey;
+	FBlackboard::FKey AttackTargetKey;
+	FBlackboard::FKey LocationKey;
+
+	/** Resolves the blackboard keys of the state machine */
+	void CacheBlackboardKeys();
+
+	/**
+	 *  Mirrors AIState values written straight to the blackboard, e.g. by BTT_SetAIState, into the native and replicated state.
+	 *  Values written by TransitionTo already match the native state and are ignored.
+	 *  Illegal transitions are refused, the native state is written back to the blackboard instead.
+	 *  @param Blackboard - The blackboard that changed
+	 *  @param ChangedKey - The AIState key
+	 */
+	EBlackboardNotificationResult OnAIStateKeyChanged(const UBlackboardComponent& Blackboard, FBlackboard::FKey ChangedKey);
+
+	/**
+	 *  Moves the state machine to a new state and writes the changed values to the blackboard.
+	 *  Unchanged values are skipped and observers are only notified once all values are written.
+	 *  @param NewState - The state to enter
+	 *  @param NewTarget - The attack target, only written when entering Attacking
+	 *  @param NewLocation - The investigated location, only written when entering Investigating
+	 *  @return false if the transition is illegal
+	 */
+	bool TransitionTo(EAIState NewState, AActor* NewTarget = nullptr, const FVector* NewLocation = nullptr);
 	
 /**
  *  AI Perception System
@@ -94,14 +147,41 @@ protected:
 	UPROPERTY()
 	UAISenseConfig_Damage* DamageConfig;
 
-	/** Handles updates form the AI perception system. Checks which actors were perceived and reacts accordingly */
-	UFUNCTION()
-	void OnPerceptionUpdated(const TArray<AActor*>& UpdatedActors);
+	/**
+	 *  Handles updates form the AI perception system, called natively by the perception component.
+	 *  Reads the perception record of each actor once and reacts to its sight, hearing and damage stimuli,
+	 *  updates arriving within the perception update interval are held back and handled together.
+	 *  @param UpdatedActors - The actors whose stimuli changed
+	 */
+	virtual void ActorsPerceptionUpdated(const TArray<AActor*>& UpdatedActors) override;
+
+public:
+	/** Sets the minimum seconds between two reactions to perception updates, set by the NPC LOD */
+	void SetPerceptionUpdateInterval(float Interval);
 
 private:
-	/** Checks if the AI can sense a given actor using a specified sense */
-	UFUNCTION()
-	bool CanSenseActor(AActor* Actor,const EAISense SenseType, FAIStimulus& OutStimulus) const;
+	/** Minimum seconds between two reactions to perception updates, 0 reacts to every update */
+	float PerceptionUpdateInterval;
+
+	/** World time perception updates were last reacted to */
+	double LastPerceptionTime;
+
+	/** Actors updated since the last reaction, handled once the interval has passed */
+	TArray<TWeakObjectPtr<AActor>> PendingPerceivedActors;
+
+	/** Handles the pending actors once the interval has passed */
+	FTimerHandle PendingPerceptionTimerHandle;
+
+	/** Reacts to the pending actors */
+	void FlushPendingPerception();
+
+	/** Reads the perception record of an actor and reacts to its sight, hearing and damage stimuli */
+	void HandlePerceivedActor(AActor* Actor);
+
+	/** Sense ids cached at BeginPlay, they index the stimuli of a perception record */
+	FAISenseID SightSenseID;
+	FAISenseID HearingSenseID;
+	FAISenseID DamageSenseID;
 
 	/** Handles AI response to sight perception */
 	UFUNCTION()
@@ -109,7 +189,7 @@ private:
 
 	/** Handles AI response to sound perception */
 	UFUNCTION()
-	void HandleSenseSound(const FVector& Location) const;
+	void HandleSenseSound(const FVector& Location);
 
 	/** Handles AI response to detecting damage */
 	UFUNCTION()
@@ -122,4 +202,7 @@ private:
  */
 	UFUNCTION()
 	bool IsOnSameTeam(AActor* OtherActor) const;
+
+	/** Whether the controlled pawn is hostile to the other actor, an attitude load between the cached and the looked up team id */
+	bool IsHostile(AActor* OtherActor) const;
 };
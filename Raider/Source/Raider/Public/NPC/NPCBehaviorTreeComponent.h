@@ -0,0 +1,30 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "NPCBehaviorTreeComponent.generated.h"
+
+/**
+ *  Behavior tree component whose tick rate can be lowered by the NPC LOD.
+ *  The tree schedules its own tick interval, so the minimum is applied after every tick.
+ */
+UCLASS()
+class RAIDER_API UNPCBehaviorTreeComponent : public UBehaviorTreeComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/**
+	 *  Sets the minimum time between two ticks, requested execution flow updates still tick right away.
+	 *  @param Interval - Minimum tick interval in seconds, 0 lets the tree decide
+	 */
+	void SetMinTickInterval(float Interval) { MinTickInterval = Interval; }
+
+private:
+	/** Minimum time between two ticks */
+	float MinTickInterval = 0.0f;
+};
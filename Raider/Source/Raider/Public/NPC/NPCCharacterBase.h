@@ -5,11 +5,14 @@
 #include "CoreMinimal.h"
 #include "GenericTeamAgentInterface.h"
 #include "../CombatSystem/Public/Interfaces/MyCombatInterface.h"
+#include "../CombatSystem/Public/Interfaces/MyPreloadInterface.h"
 #include "GameFramework/Character.h"
+#include "NPC/Enums/EAIState.h"
 #include "NPCCharacterBase.generated.h"
 
 class UMyCombatComponent;
 class UMyHealthComponent;
+class UMyMontageDispatcherComponent;
 class UBehaviorTree;
 struct FSDamageInfo;
 
@@ -19,15 +22,19 @@ struct FSDamageInfo;
  *  ========================================================
  */
 UCLASS()
-class RAIDER_API ANPCCharacterBase : public ACharacter, public IMyCombatInterface
+class RAIDER_API ANPCCharacterBase : public ACharacter, public IMyCombatInterface, public IMyPreloadInterface
 {
 	GENERATED_BODY()
 
 public:
 	ANPCCharacterBase();
 
+	/** Adds the behavior tree, the components add their own assets */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	virtual void Tick(float DeltaTime) override;
@@ -42,7 +49,7 @@ public:
 public:
 	/** Each AI Character type can assign a unique behavior tree, which can be retrieved from AI Controller */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC|AIController")
-	TObjectPtr<UBehaviorTree> BehaviorTreeAsset;
+	TSoftObjectPtr<UBehaviorTree> BehaviorTreeAsset;
 
 /**
  *	---------------------------------------------
@@ -53,11 +60,48 @@ public:
 	UFUNCTION(Category = "Player")
 	virtual int32 GetTeamNumber_Implementation() override;
 
+	/** Sets the team number, the combat component reads it when it registers at BeginPlay so set it before spawning finishes */
+	void SetTeamNumber(const int32 InTeamNumber) { TeamNumber = InTeamNumber; }
+
 private:
 	/** Default team number */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Player|Team", meta = (AllowPrivateAccess = "true"))
 	int32 TeamNumber;
-	
+
+/**
+ *	---------------------------------------------
+ *  Replication
+ *  ---------------------------------------------
+ */
+public:
+	/** The AI state replicates push based, only when the controller changes it */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/**
+	 *  Mirrors the state of the AI controller, which only exists on the server. Wakes the NPC from
+	 *  net dormancy, then lets it sleep again when the new state allows.
+	 *  @param NewState - The state the AI controller entered
+	 */
+	void SetReplicatedAIState(EAIState NewState);
+
+	/** Called by the AI controller when a move starts or ends, passive NPCs only sleep while they stand */
+	void SetAIMoving(bool bMoving);
+
+	/** State of the AI controller, also valid on clients */
+	UFUNCTION(BlueprintPure, Category = "NPC|AIController")
+	EAIState GetReplicatedAIState() const { return ReplicatedAIState; }
+
+private:
+	/** Copy of the AI controller state for clients */
+	UPROPERTY(Replicated)
+	EAIState ReplicatedAIState = EAIState::Passive;
+
+	/** Whether the AI controller is moving the NPC */
+	bool bIsAIMoving = false;
+
+	/** Sends pending changes, then puts passive NPCs which stand and dead NPCs to sleep and wakes the others */
+	void UpdateNetDormancy();
+
 /**
  *	---------------------------------------------
  *  Combat Component & Interface
@@ -68,6 +112,10 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
 	UMyCombatComponent* CombatComponent;
 
+	/** Component playing NPC combat montages and routing their events */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
+	UMyMontageDispatcherComponent* MontageDispatcherComponent;
+
 	/** NPCCombatInterface, check if currently has a weapon equipped */
 	UFUNCTION(Category = "NPC")
 	virtual bool IsWeaponEquipped_Implementation() override;
@@ -173,6 +221,42 @@ protected:
 	 */
 	float GetMovementSpeed(ECharacterMovementState InMovementState);
 
+/**
+ *	---------------------------------------------
+ *  Pooling
+ *  ---------------------------------------------
+ */
+public:
+	/** Seconds the corpse stays before it is returned to the NPC pool */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC|Pooling")
+	float CorpseLifeSpan;
+
+	/** Resets the NPC and parks it hidden, without collision, movement, ticking or AI logic */
+	void DeactivateForPool();
+
+	/**
+	 *  Brings a parked NPC back with full health, an idle AI state and its collision and movement restored.
+	 *  @param SpawnTransform - Where the NPC appears
+	 */
+	void ActivateFromPool(const FTransform& SpawnTransform);
+
+	/** Whether the NPC is parked in the NPC pool */
+	bool IsPooled() const { return bIsPooled; }
+
+private:
+	/** Whether the NPC is parked in the NPC pool */
+	bool bIsPooled;
+
+	/** Collision of the capsule and collision profile of the mesh before death, restored on reactivation */
+	ECollisionEnabled::Type DefaultCapsuleCollision;
+	FName DefaultMeshCollisionProfile;
+
+	/** Timer returning the corpse to the pool */
+	FTimerHandle CorpseTimerHandle;
+
+	/** Returns the corpse to the NPC pool, or destroys it without a pool */
+	void OnCorpseExpired();
+
 /**
  *	---------------------------------------------
  *  Delegate Events
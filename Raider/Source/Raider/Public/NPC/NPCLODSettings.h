@@ -0,0 +1,41 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "NPC/Structs/FNPCLODBucket.h"
+#include "NPCLODSettings.generated.h"
+
+/**
+ *  =====================================================
+ *  Project settings describing the NPC level of detail buckets.
+ *  Read by the NPC LOD subsystem when it sorts NPCs by their distance to the players.
+ *  =====================================================
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "NPC LOD"))
+class RAIDER_API UNPCLODSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNPCLODSettings();
+
+	virtual FName GetCategoryName() const override;
+
+	/** Seconds it takes to re-evaluate every NPC, the work is spread over the frames */
+	UPROPERTY(Config, EditAnywhere, Category = "LOD", meta = (ClampMin = "0.0"))
+	float UpdateInterval;
+
+	/** Distance past a bucket border an NPC has to move before it changes bucket */
+	UPROPERTY(Config, EditAnywhere, Category = "LOD", meta = (ClampMin = "0.0"))
+	float HysteresisDistance;
+
+	/** Distance multiplier for NPCs which were not rendered recently */
+	UPROPERTY(Config, EditAnywhere, Category = "LOD", meta = (ClampMin = "1.0"))
+	float OffscreenDistanceScale;
+
+	/** Buckets sorted by MaxDistance, NPCs beyond the last one use the last one */
+	UPROPERTY(Config, EditAnywhere, Category = "LOD")
+	TArray<FNPCLODBucket> Buckets;
+};
@@ -0,0 +1,84 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NPCLODSubsystem.generated.h"
+
+class ANPCCharacterBase;
+class UNPCLODSettings;
+
+/** An NPC tracked by the LOD subsystem */
+struct FNPCLODEntry
+{
+	/** The NPC */
+	TWeakObjectPtr<ANPCCharacterBase> Character;
+
+	/** Bucket applied to the NPC, INDEX_NONE until the first evaluation */
+	int32 Bucket = INDEX_NONE;
+};
+
+/**
+ *  =====================================================
+ *  Sorts NPCs into level of detail buckets by their distance to the closest player view.
+ *  Each bucket lowers the tick rate of the NPC, its controller, behavior tree, movement and
+ *  animation, far buckets also stop looking for targets. NPCs are re-evaluated a slice per
+ *  frame, and only change bucket once they are clearly past a border.
+ *  =====================================================
+ */
+UCLASS()
+class RAIDER_API UNPCLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 *  Starts sorting an NPC into LOD buckets, it runs at full rate until its first evaluation.
+	 *  @param Character - The NPC to track
+	 */
+	void RegisterNPC(ANPCCharacterBase* Character);
+
+	/**
+	 *  Stops sorting an NPC and restores its full update rate.
+	 *  @param Character - The NPC to remove
+	 */
+	void UnregisterNPC(ANPCCharacterBase* Character);
+
+	/** Prints the number of NPCs per bucket */
+	void DumpStats() const;
+
+private:
+	/** LOD settings, read once per world */
+	UPROPERTY()
+	TObjectPtr<const UNPCLODSettings> Settings;
+
+	/** Tracked NPCs */
+	TArray<FNPCLODEntry> NPCs;
+
+	/** Next NPC to evaluate */
+	int32 NextEntryIndex = 0;
+
+	/** Fractional number of NPCs carried over to the next frame */
+	float PendingEvaluations = 0.0f;
+
+	/** Player view locations gathered this frame */
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+
+	/** Finds the bucket of an NPC, keeping the current one inside the hysteresis band */
+	int32 EvaluateBucket(const ANPCCharacterBase* Character, int32 CurrentBucket) const;
+
+	/** Finds the bucket covering a distance */
+	int32 GetBucketForDistance(float Distance) const;
+
+	/** Applies the update rates of a bucket, INDEX_NONE restores the full rate */
+	void ApplyBucket(ANPCCharacterBase* Character, int32 Bucket) const;
+
+	/** Collects the view locations of all players */
+	void GatherViewLocations();
+};
@@ -0,0 +1,101 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NPCPoolSubsystem.generated.h"
+
+class ANPCCharacterBase;
+
+/** NPC pool counters of one class since the world started or the last reset */
+struct FNPCPoolStats
+{
+	/** NPCs created because the pool was empty, or to prewarm it */
+	int32 NumSpawned = 0;
+
+	/** NPCs destroyed because the pool was full */
+	int32 NumDestroyed = 0;
+
+	/** NPCs handed out from the pool */
+	int32 NumReused = 0;
+
+	/** NPCs returned to the pool */
+	int32 NumReleased = 0;
+
+	/** NPCs handed out and not returned yet */
+	int32 NumActive = 0;
+
+	/** High-water mark of the active NPCs */
+	int32 PeakActive = 0;
+
+	/** High-water mark of the parked NPCs */
+	int32 PeakPooled = 0;
+};
+
+/** Parked NPCs and counters of one class */
+struct FNPCPool
+{
+	/** NPCs waiting to be reactivated */
+	TArray<TWeakObjectPtr<ANPCCharacterBase>> Parked;
+
+	/** Pool counters */
+	FNPCPoolStats Stats;
+};
+
+/**
+ *  =====================================================
+ *  Keeps dead NPCs per class, reset and parked hidden without collision, ticking or AI logic,
+ *  so enemy waves reactivate them instead of constructing and garbage collecting new ones.
+ *  =====================================================
+ */
+UCLASS()
+class RAIDER_API UNPCPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 *  Reactivates a parked NPC of the class, or spawns one when the pool is empty.
+	 *  @param NPCClass - The NPC class
+	 *  @param SpawnTransform - Where the NPC appears
+	 *  @return The active NPC
+	 */
+	ANPCCharacterBase* AcquireNPC(TSubclassOf<ANPCCharacterBase> NPCClass, const FTransform& SpawnTransform);
+
+	/**
+	 *  Resets and parks an NPC for reuse. NPCs above the pool limit are destroyed.
+	 *  @param Character - The NPC to return
+	 */
+	void ReleaseNPC(ANPCCharacterBase* Character);
+
+	/**
+	 *  Spawns and parks NPCs until the class has the given number parked.
+	 *  @param NPCClass - The NPC class
+	 *  @param Count - Number of parked NPCs wanted, capped by the pool limit
+	 *  @return Number of NPCs spawned
+	 */
+	int32 Prewarm(TSubclassOf<ANPCCharacterBase> NPCClass, int32 Count);
+
+	/** Pool counters of a class, null if the class was never pooled */
+	const FNPCPoolStats* GetStats(TSubclassOf<ANPCCharacterBase> NPCClass) const;
+
+	/** Logs the pool counters of every class and their rates */
+	void DumpStats() const;
+
+	/** Clears the pool counters, the high-water marks restart from the current counts */
+	void ResetStats();
+
+private:
+	/** Parked NPCs and counters per class */
+	TMap<TSubclassOf<ANPCCharacterBase>, FNPCPool> Pools;
+
+	/** World time the counters started at */
+	double StatsStartTime = 0.0;
+
+	/** Counts an NPC handed out and updates the high-water mark */
+	static void MarkActive(FNPCPool& Pool);
+};
@@ -0,0 +1,36 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "NPCSpawnPoint.generated.h"
+
+class UArrowComponent;
+
+/**
+ *	========================================================
+ *  A location enemies are spawned at. Spawn points add themselves to the spawn point
+ *  registry when their level loads or streams in, and leave it when it unloads.
+ *  ========================================================
+ */
+UCLASS()
+class RAIDER_API ANPCSpawnPoint : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ANPCSpawnPoint();
+
+	virtual void PostInitializeComponents() override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+#if WITH_EDITORONLY_DATA
+private:
+	/** Shows the spawn direction in the editor */
+	UPROPERTY()
+	TObjectPtr<UArrowComponent> ArrowComponent;
+#endif
+};
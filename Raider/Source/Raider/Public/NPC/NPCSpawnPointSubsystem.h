@@ -0,0 +1,165 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NPCSpawnPointSubsystem.generated.h"
+
+/** A spawn point tracked by the registry */
+struct FNPCSpawnPointEntry
+{
+	/** The spawn point actor */
+	TWeakObjectPtr<AActor> Actor;
+
+	/** Key of the actor in the entry index lookup */
+	TObjectKey<AActor> ActorKey;
+
+	/** Spawn point location when it registered, spawn points don't move */
+	FVector Location = FVector::ZeroVector;
+
+	/** Grid cell the spawn point is stored in */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+};
+
+/** The spawn points of one class, packed for random picks and bucketed in a grid for spatial queries */
+struct FNPCSpawnPointSet
+{
+	/** Registered spawn points */
+	TArray<FNPCSpawnPointEntry> Entries;
+
+	/** Entry index per actor */
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+
+	/** Entry indices per grid cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** Smallest and largest cell ever used, bounds the nearest spawn point search */
+	FIntPoint MinCell = FIntPoint(MAX_int32, MAX_int32);
+	FIntPoint MaxCell = FIntPoint(MIN_int32, MIN_int32);
+};
+
+/**
+ *  =====================================================
+ *  Registry of the enemy spawn points of the loaded levels. Answers random, nearest and
+ *  distance and visibility filtered queries without iterating the actors of the world.
+ *  ANPCSpawnPoint actors register themselves, other spawn point classes are tracked on request.
+ *  =====================================================
+ */
+UCLASS()
+class RAIDER_API UNPCSpawnPointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+/**
+ *	---------------------------------------------
+ *  Registration
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Starts tracking a spawn point.
+	 *  @param SpawnPoint - The spawn point actor, tracked at its current location
+	 */
+	void RegisterSpawnPoint(AActor* SpawnPoint);
+
+	/**
+	 *  Stops tracking a spawn point.
+	 *  @param SpawnPoint - The spawn point actor
+	 */
+	void UnregisterSpawnPoint(const AActor* SpawnPoint);
+
+	/**
+	 *  Tracks the actors of a spawn point class which doesn't derive from ANPCSpawnPoint, such as
+	 *  older Blueprint spawn points. Actors already loaded are registered right away, actors of levels
+	 *  streamed in later when their level is added.
+	 *  @param SpawnPointClass - The spawn point class
+	 */
+	void TrackSpawnPointClass(TSubclassOf<AActor> SpawnPointClass);
+
+/**
+ *	---------------------------------------------
+ *  Queries
+ *  ---------------------------------------------
+ */
+public:
+	/**
+	 *  Collects every registered spawn point of a class.
+	 *  @param SpawnPointClass - The spawn point class, subclasses are included
+	 *  @param OutSpawnPoints - Receives the spawn points
+	 *  @return Number of spawn points added to OutSpawnPoints
+	 */
+	int32 GetSpawnPoints(TSubclassOf<AActor> SpawnPointClass, TArray<AActor*>& OutSpawnPoints) const;
+
+	/**
+	 *  Picks a random spawn point of a class.
+	 *  @param SpawnPointClass - The spawn point class, subclasses are included
+	 *  @return The spawn point, null if none is registered
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NPC|Spawn")
+	AActor* GetRandomSpawnPoint(TSubclassOf<AActor> SpawnPointClass) const;
+
+	/**
+	 *  Finds the spawn point of a class closest to a location.
+	 *  @param SpawnPointClass - The spawn point class, subclasses are included
+	 *  @param Location - The location to search around
+	 *  @return The spawn point, null if none is registered
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NPC|Spawn")
+	AActor* FindNearestSpawnPoint(TSubclassOf<AActor> SpawnPointClass, const FVector& Location) const;
+
+	/**
+	 *  Collects the spawn points of a class inside a distance band around a location, for example
+	 *  the ones within 3000 units of the player that no player can see.
+	 *  @param SpawnPointClass - The spawn point class, subclasses are included
+	 *  @param Origin - Center of the distance band
+	 *  @param MinDistance - Spawn points closer than this are skipped
+	 *  @param MaxDistance - Spawn points further than this are skipped, 0 disables the limit
+	 *  @param bExcludeInView - Whether spawn points inside the view of a player are skipped
+	 *  @param OutSpawnPoints - Receives the spawn points
+	 *  @return Number of spawn points added to OutSpawnPoints
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NPC|Spawn")
+	int32 QuerySpawnPoints(TSubclassOf<AActor> SpawnPointClass, const FVector& Origin, float MinDistance, float MaxDistance,
+	                       bool bExcludeInView, TArray<AActor*>& OutSpawnPoints) const;
+
+	/** Number of registered spawn points of every class */
+	int32 GetNumSpawnPoints() const;
+
+private:
+	/** Spawn points per actor class */
+	TMap<TSubclassOf<AActor>, FNPCSpawnPointSet> SpawnPointSets;
+
+	/** Spawn point classes registered when their level is added */
+	TArray<TSubclassOf<AActor>> TrackedClasses;
+
+	/** Handle of the level added binding, set while classes are tracked */
+	FDelegateHandle LevelAddedHandle;
+
+	/** Edge length of a grid cell */
+	float CellSize = 2000.0f;
+
+	/** Converts a world location to its grid cell */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Calls Visitor for every set whose class is the given class or one of its subclasses */
+	template <typename VisitorType>
+	void ForEachSet(TSubclassOf<AActor> SpawnPointClass, VisitorType&& Visitor) const;
+
+	/** Finds the entry of a set closest to a location by searching the grid in growing rings */
+	const FNPCSpawnPointEntry* FindNearestEntry(const FNPCSpawnPointSet& Set, const FVector& Location) const;
+
+	/** Registers a spawn point of a tracked class and unregisters it when it ends play */
+	void RegisterTrackedSpawnPoint(AActor* SpawnPoint);
+
+	/** Registers the actors of the tracked classes in a level which was streamed in */
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	/** Unregisters a spawn point of a tracked class when its level unloads */
+	UFUNCTION()
+	void OnTrackedSpawnPointEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+};
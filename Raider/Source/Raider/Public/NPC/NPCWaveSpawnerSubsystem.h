@@ -0,0 +1,96 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NPC/Structs/FNPCPlayerView.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NPCWaveSpawnerSubsystem.generated.h"
+
+/** Delegate to notify subscribers when every spawn of a wave was processed */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnNPCWaveFinished, int32, WaveId, int32, NumSpawned);
+
+/** An enemy waiting to be spawned */
+struct FNPCSpawnRequest
+{
+	/** The enemy class */
+	TSubclassOf<AActor> EnemyClass;
+
+	/** Where the enemy appears */
+	FTransform SpawnTransform;
+
+	/** Wave the request belongs to */
+	int32 WaveId = INDEX_NONE;
+
+	/** Spawn order, lower spawns first. Distance to the closest player view, scaled up outside the view */
+	float Priority = 0.0f;
+};
+
+/** Progress of a queued wave */
+struct FNPCWave
+{
+	/** Requests not processed yet */
+	int32 NumPending = 0;
+
+	/** Enemies spawned so far */
+	int32 NumSpawned = 0;
+
+	/** World time the wave was queued at */
+	double StartTime = 0.0;
+
+	/** Frame the wave was queued at */
+	uint64 StartFrame = 0;
+};
+
+/**
+ *  =====================================================
+ *  Queues the enemies of a wave and spawns them over several frames, within a per-frame
+ *  time and count budget. Requests closest to a player view spawn first, and a wave reports
+ *  once all of its requests were processed.
+ *  =====================================================
+ */
+UCLASS()
+class RAIDER_API UNPCWaveSpawnerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 *  Queues one enemy per spawn transform, they are spawned over the next frames.
+	 *  NPC classes are taken from the NPC pool, other classes are spawned as is.
+	 *  @param EnemyClass - The enemy class
+	 *  @param SpawnTransforms - Where the enemies appear
+	 *  @return Id of the wave, passed to OnWaveFinished, INDEX_NONE if nothing was queued
+	 */
+	int32 QueueWave(TSubclassOf<AActor> EnemyClass, TConstArrayView<FTransform> SpawnTransforms);
+
+	/** Number of enemies waiting to be spawned */
+	int32 GetNumPendingSpawns() const { return PendingRequests.Num(); }
+
+	/** Delegate event triggered when every spawn of a wave was processed */
+	UPROPERTY(BlueprintAssignable, Category = "NPC|Spawn")
+	FOnNPCWaveFinished OnWaveFinished;
+
+private:
+	/** Requests waiting to be spawned, ordered by priority while processing */
+	TArray<FNPCSpawnRequest> PendingRequests;
+
+	/** Waves with pending requests */
+	TMap<int32, FNPCWave> Waves;
+
+	/** Id handed to the next queued wave */
+	int32 NextWaveId = 0;
+
+	/** Player views gathered this frame */
+	TArray<FNPCPlayerView, TInlineAllocator<4>> Views;
+
+	/** Orders the pending requests so the ones closest to a player view come first */
+	void PrioritizeRequests();
+
+	/** Spawns the enemy of a request, through the NPC pool when possible */
+	AActor* SpawnEnemy(const FNPCSpawnRequest& Request) const;
+};
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "FNPCLODBucket.generated.h"
+
+/** Struct to store how often an NPC updates while it is inside a distance band */
+USTRUCT(BlueprintType)
+struct FNPCLODBucket
+{
+	GENERATED_BODY()
+
+	/** NPCs up to this distance from the closest player view use the bucket */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float MaxDistance = 0.0f;
+
+	/** Tick interval of the NPC and its controller, 0 ticks every frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float ActorTickInterval = 0.0f;
+
+	/** Minimum tick interval of the behavior tree, events still run it right away */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float BehaviorTreeTickInterval = 0.0f;
+
+	/** Tick interval of the character movement */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float MovementTickInterval = 0.0f;
+
+	/** Tick interval of the mesh, which updates the animation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float AnimationTickInterval = 0.0f;
+
+	/** Whether the mesh keeps animating while it isn't rendered */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EVisibilityBasedAnimTickOption AnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	/** Minimum seconds between two reactions to perception updates, the updates in between are handled together */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float PerceptionUpdateInterval = 0.0f;
+
+	/** Whether the NPC keeps looking for targets, hearing and damage are always perceived */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnableSight = true;
+};
@@ -0,0 +1,26 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+/** A player view, used to find out which NPCs and spawn points the players can see */
+struct FNPCPlayerView
+{
+	/** View location */
+	FVector Location = FVector::ZeroVector;
+
+	/** View direction */
+	FVector Direction = FVector::ForwardVector;
+
+	/** Cosine of half the horizontal field of view */
+	float CosHalfFOV = 0.0f;
+
+	/** Whether a location is inside the view cone */
+	bool IsInView(const FVector& InLocation) const;
+
+	/**
+	 *  Collects the views of all players.
+	 *  @param World - The world of the players
+	 *  @param OutViews - Receives one view per player controller
+	 */
+	static void GatherPlayerViews(const UWorld* World, TArray<FNPCPlayerView, TInlineAllocator<4>>& OutViews);
+};
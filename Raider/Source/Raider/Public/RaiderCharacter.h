@@ -11,6 +11,7 @@ class UMyComboAttackComponent;
 class UMySpinAttackComponent;
 class UMyCombatComponent;
 class UMyHealthComponent;
+class UMyMontageDispatcherComponent;
 
 UCLASS(Blueprintable)
 class ARaiderCharacter : public ACharacter, public IMyCombatInterface
@@ -80,6 +81,10 @@ public:
 	/** Component handling spin attack */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Player|Combat")
 	UMySpinAttackComponent* SpinAttackComponent;
+
+	/** Component playing combat montages and routing their events */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Player|Combat")
+	UMyMontageDispatcherComponent* MontageDispatcherComponent;
 	
 protected:
 	/** NPCCombatInterface, equip weapon function */
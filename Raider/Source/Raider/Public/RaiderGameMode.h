@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "RaiderGameMode.generated.h"
 
+class ANPCCharacterBase;
+
 /**
  *	GameMode for project Raider
  */
@@ -24,25 +26,39 @@ protected:
  *	NPC related
  */
 public:
-	/* Define enemy class */
+	/* Define enemy class, streamed in with its assets before the first wave */
 	UPROPERTY(EditAnywhere, Category = "Default|NPC")
-	TSubclassOf<AActor> EnemyClass;
+	TSoftClassPtr<AActor> EnemyClass;
 
 	/* Define NPC spawn point class */
 	UPROPERTY(EditAnywhere, Category = "Default|NPC")
 	TSubclassOf<AActor> NPCSpawnPointClass;
+
+	/* Number of NPCs parked in the NPC pool per class before the first wave, so waves reactivate them instead of spawning */
+	UPROPERTY(EditAnywhere, Category = "Default|NPC")
+	TMap<TSoftClassPtr<ANPCCharacterBase>, int32> NPCPoolPrewarmCounts;
 	
-	/* Spawn new wave of enemies */
+	/* Preload the enemy class and its assets, then queue a new wave of enemies spawned over the next frames by the wave spawner */
 	UFUNCTION()
-	void StartEnemySpawn(const TSubclassOf<AActor>& InEnemyClass, const TSubclassOf<AActor>& InSpawnPointClass) const;
+	void StartEnemySpawn(const TSoftClassPtr<AActor>& InEnemyClass, const TSubclassOf<AActor>& InSpawnPointClass);
+
+	/* Preload the enemy class and its assets, then queue a new wave of enemies at the given transforms */
+	void StartEnemySpawnAt(const TSoftClassPtr<AActor>& InEnemyClass, const TArray<FTransform>& SpawnTransforms);
 	
 protected:
+	/* Called once the prewarmed NPC classes are loaded, fills the NPC pool and starts the first wave */
+	void OnNPCPoolPreloaded(double LoadSeconds);
+
+	/* Called once the enemy class of a wave is loaded, queues the wave */
+	void OnEnemyWavePreloaded(double LoadSeconds, TSoftClassPtr<AActor> InEnemyClass, TArray<FTransform> SpawnTransforms);
+
 	/* Search NPC spawn points in the level to spawn NPC */
 	UFUNCTION()
 	FTransform GetRandomSpawnPoints(const TSubclassOf<AActor>& InSpawnPointClass) const;
 
-	/* Spawn enemy by given enemy class */
-	void SpawnEnemy(const TSubclassOf<AActor>& InEnemyClass, const FTransform& InSpawnPoint) const;
+	/* Called by the wave spawner once every enemy of a wave was spawned */
+	UFUNCTION()
+	void OnEnemyWaveFinished(int32 WaveId, int32 NumSpawned);
 };
 
 
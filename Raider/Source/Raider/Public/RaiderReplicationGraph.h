@@ -0,0 +1,72 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "RaiderReplicationGraph.generated.h"
+
+/** How the actors of a class are routed to the nodes of the replication graph */
+enum class ERaiderClassRepNodeMapping : uint8
+{
+	/** Not routed to a global node, such as player controllers which the connection node covers */
+	NotRouted,
+
+	/** Relevant to every connection, such as the player characters, the game state and player states */
+	RelevantAllConnections,
+
+	/** Spatialized, actors which never move */
+	Spatialize_Static,
+
+	/** Spatialized, actors which move */
+	Spatialize_Dynamic,
+
+	/** Spatialized, actors which move while awake and are treated as static while dormant, such as NPCs */
+	Spatialize_Dormancy,
+};
+
+/**
+ *  =====================================================
+ *  Replication graph of game net drivers. NPCs are bucketed in a spatial grid, so a connection
+ *  only considers the cells around its viewers instead of every NPC of the world, and dormant
+ *  NPCs are skipped until they wake up. Player characters are relevant to every connection.
+ *  Raider.Net.UseReplicationGraph 0 falls back to the engine's per-actor relevancy.
+ *  =====================================================
+ */
+UCLASS(Transient)
+class RAIDER_API URaiderReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	/**
+	 *  Creates the replication graph of a net driver, bound to UReplicationDriver::CreateReplicationDriverDelegate
+	 *  when the module starts.
+	 *  @param ForNetDriver - The net driver being initialized
+	 *  @param URL - URL the net driver listens on or connects to
+	 *  @param World - The world of the net driver
+	 *  @return The replication graph, null for the default replication of the net driver
+	 */
+	static UReplicationDriver* CreateForNetDriver(UNetDriver* ForNetDriver, const FURL& URL, UWorld* World);
+
+private:
+	/** Grid of the spatialized actors */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	/** Actors relevant to every connection */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	/** Routing per actor class, classes loaded later use the routing of their closest parent */
+	TClassMap<ERaiderClassRepNodeMapping> ClassRepNodePolicies;
+
+	/** Picks the routing of a class from its default object */
+	ERaiderClassRepNodeMapping GetMappingPolicy(const UClass* Class) const;
+};
@@ -0,0 +1,36 @@
+﻿// Copyright © 2025 Felix Ho. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+/**
+ *  Stat groups, per-frame counters and the trace channel of the combat and AI hot paths.
+ *  "stat RaiderCombat" and "stat RaiderAI" show them in game, Insights captures started with
+ *  -trace=cpu,Raider add the scopes of the Raider channel to the CPU track.
+ */
+DECLARE_STATS_GROUP(TEXT("RaiderCombat"), STATGROUP_RaiderCombat, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("RaiderAI"), STATGROUP_RaiderAI, STATCAT_Advanced);
+
+/** Trace channel of the combat and AI CPU scopes */
+UE_TRACE_CHANNEL_EXTERN(RaiderChannel, RAIDER_API);
+
+/** Combat counters, reset every frame */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Queried"), STAT_RaiderHitsQueried, STATGROUP_RaiderCombat, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Applied"), STAT_RaiderHitsApplied, STATGROUP_RaiderCombat, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events Applied"), STAT_RaiderDamageEventsApplied, STATGROUP_RaiderCombat, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Reactions Played"), STAT_RaiderReactionsPlayed, STATGROUP_RaiderCombat, RAIDER_API);
+
+/** AI counters, reset every frame */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Perception Events"), STAT_RaiderPerceptionEvents, STATGROUP_RaiderAI, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Blackboard Writes"), STAT_RaiderBlackboardWrites, STATGROUP_RaiderAI, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Token Requests"), STAT_RaiderTokenRequests, STATGROUP_RaiderAI, RAIDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Token Grants"), STAT_RaiderTokenGrants, STATGROUP_RaiderAI, RAIDER_API);
+
+/** Times the enclosing scope with a cycle stat declared by DECLARE_CYCLE_STAT, and traces it on the Raider channel */
+#define RAIDER_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, RaiderChannel)
@@ -15,7 +15,10 @@ public class Raider : ModuleRules
 		        "AIModule", 
 		        "Niagara", 
 		        "EnhancedInput",
-		        "UMG"
+		        "UMG",
+		        "DeveloperSettings",
+		        "NetCore",
+		        "ReplicationGraph"
 	        });
         
         PublicIncludePaths.AddRange(new string[] 
@@ -0,0 +1,21 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class RaiderServerTarget : TargetRules
+{
+	public RaiderServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+		ExtraModuleNames.Add("Raider");
+
+		// Combat state replicates push based, see Net.IsPushModelEnabled in DefaultEngine.ini.
+		// Server targets need a source build of the engine anyway, so a unique build environment costs nothing here.
+		// The game and editor targets keep the shared environment of the launcher engine and compare the properties instead.
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+		bWithPushModel = true;
+	}
+}